@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../reloj.h"
+#include "../lib.h"
+#include "../blockchain.h"
+#include "../billetera.h"
+
+using namespace std;
+
+/*
+ * Compara el costo de abrir billeteras y registrar transacciones entre la
+ * configuración completa y la que sólo mantiene saldos.
+ *
+ * Uso: bench_politicas [billeteras] [transacciones]
+ */
+
+struct Resultado {
+  double segundos;
+  size_t bytes_por_billetera;
+};
+
+template <class Politica>
+Resultado correr(unsigned int cantidad_billeteras, unsigned int cantidad_transacciones) {
+  srand(1);
+
+  RelojManual reloj(0);
+  BlockchainGenerica<Politica> blockchain(&reloj);
+  vector<BilleteraGenerica<Politica>*> billeteras;
+
+  auto inicio = chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < cantidad_billeteras; i++) {
+    billeteras.push_back(blockchain.abrir_billetera());
+  }
+
+  for (unsigned int i = 0; i < cantidad_transacciones; i++) {
+    // Cada 1000 transacciones pasa un minuto, para que haya varios días.
+    if (i % 1000 == 0) {
+      reloj.avanzar_un_minuto();
+    }
+    BilleteraGenerica<Politica>* origen = billeteras[rand() % cantidad_billeteras];
+    id_billetera destino = billeteras[rand() % cantidad_billeteras]->id();
+    blockchain.agregar_transaccion(origen, destino, 1);
+  }
+
+  auto fin = chrono::steady_clock::now();
+
+  return {chrono::duration<double>(fin - inicio).count(), sizeof(BilleteraGenerica<Politica>)};
+}
+
+int main(int argc, char** argv) {
+  unsigned int cantidad_billeteras = argc > 1 ? atoi(argv[1]) : 1000;
+  unsigned int cantidad_transacciones = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  Resultado completa = correr<PoliticaCompleta>(cantidad_billeteras, cantidad_transacciones);
+  Resultado solo_saldo = correr<PoliticaSoloSaldo>(cantidad_billeteras, cantidad_transacciones);
+
+  cout << "billeteras: " << cantidad_billeteras << ", transacciones: " << cantidad_transacciones << endl;
+  cout << "PoliticaCompleta:  " << completa.segundos << " s, "
+       << completa.bytes_por_billetera << " bytes por billetera (sin contar el heap)" << endl;
+  cout << "PoliticaSoloSaldo: " << solo_saldo.segundos << " s, "
+       << solo_saldo.bytes_por_billetera << " bytes por billetera" << endl;
+  cout << "speedup: " << completa.segundos / solo_saldo.segundos << "x" << endl;
+
+  return 0;
+}
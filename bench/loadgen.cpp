@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../reloj.h"
+#include "../lib.h"
+#include "../blockchain.h"
+#include "../billetera.h"
+
+using namespace std;
+
+/*
+ * Generador de carga sintética y reproductor de trazas para `Blockchain`.
+ *
+ * Genera (o lee de una traza) una secuencia de operaciones y la ejecuta contra
+ * una blockchain con el tiempo controlado por un `RelojManual`, de modo que
+ * dos corridas con la misma semilla son idénticas. Reporta el throughput y los
+ * percentiles de latencia de cada tipo de operación.
+ *
+ * Uso: loadgen [opciones]
+ *   --billeteras N            billeteras a abrir, al menos 2 (1000)
+ *   --transacciones N         transferencias a intentar (1000000)
+ *   --destinatarios D         distribución de destinatarios: uniforme | zipf (uniforme)
+ *   --zipf-s S                exponente de la distribución zipf (1.1)
+ *   --dormidas F              fracción de billeteras que sólo operan al abrirse y al final (0)
+ *   --transacciones-por-dia N transferencias entre cada avance de día (1000)
+ *   --semilla S               semilla del generador (1)
+ *   --politica P              completa | solo_saldo (completa)
+ *   --grabar ARCHIVO          guarda la traza generada
+ *   --reproducir ARCHIVO      ejecuta una traza grabada en vez de generar una
+ */
+
+namespace {
+
+/**
+ * Operación de la traza. Las billeteras se identifican por su orden de
+ * apertura, para que la traza no dependa de los ids que asigne la blockchain.
+ *   - 'A': abrir una billetera
+ *   - 'T': transferir `monto` de la billetera `origen` a la `destino`
+ *   - 'D': avanzar un día
+ *   - 'M': avanzar un minuto
+ */
+struct Operacion {
+  char tipo;
+  unsigned int origen;
+  unsigned int destino;
+  double monto;
+};
+
+struct Opciones {
+  unsigned int billeteras = 1000;
+  unsigned int transacciones = 1000000;
+  string destinatarios = "uniforme";
+  double zipf_s = 1.1;
+  double dormidas = 0;
+  unsigned int transacciones_por_dia = 1000;
+  unsigned long semilla = 1;
+  string politica = "completa";
+  string grabar;
+  string reproducir;
+};
+
+/** Muestrea índices en [0, n) con probabilidad proporcional a 1 / (i + 1)^s. */
+class DistribucionZipf {
+  public:
+    DistribucionZipf(unsigned int n, double s) : _acumulada(n) {
+      double total = 0;
+      for (unsigned int i = 0; i < n; i++) {
+        total += 1.0 / pow(i + 1, s);
+        _acumulada[i] = total;
+      }
+      for (unsigned int i = 0; i < n; i++) {
+        _acumulada[i] /= total;
+      }
+    }
+
+    unsigned int operator()(mt19937_64& generador) {
+      double u = uniform_real_distribution<double>(0, 1)(generador);
+      size_t i = lower_bound(_acumulada.begin(), _acumulada.end(), u) - _acumulada.begin();
+      return static_cast<unsigned int>(min(i, _acumulada.size() - 1));
+    }
+
+  private:
+    vector<double> _acumulada;
+};
+
+vector<Operacion> generar(const Opciones& opciones) {
+  vector<Operacion> operaciones;
+  mt19937_64 generador(opciones.semilla);
+
+  unsigned int dormidas = static_cast<unsigned int>(opciones.billeteras * opciones.dormidas);
+  // Con muchas dormidas dejo al menos dos activas; el total no cambia.
+  unsigned int activas = max(2u, opciones.billeteras - dormidas);
+  dormidas = opciones.billeteras - min(activas, opciones.billeteras);
+
+  for (unsigned int i = 0; i < activas + dormidas; i++) {
+    operaciones.push_back({'A', 0, 0, 0});
+  }
+
+  // Los destinatarios más frecuentes son los de menor índice. Con zipf se
+  // estresa el ranking de destinatarios de los que más envían.
+  DistribucionZipf zipf(activas, opciones.zipf_s);
+  uniform_int_distribution<unsigned int> uniforme(0, activas - 1);
+
+  for (unsigned int i = 0; i < opciones.transacciones; i++) {
+    if (i > 0 && i % opciones.transacciones_por_dia == 0) {
+      operaciones.push_back({'D', 0, 0, 0});
+    } else if (i > 0) {
+      operaciones.push_back({'M', 0, 0, 0});
+    }
+
+    unsigned int origen = uniforme(generador);
+    unsigned int destino = opciones.destinatarios == "zipf" ? zipf(generador) : uniforme(generador);
+    operaciones.push_back({'T', origen, destino, 1});
+  }
+
+  // Las billeteras dormidas despiertan al final, lo que obliga a completar el
+  // saldo de todos los días transcurridos desde su apertura.
+  for (unsigned int i = 0; i < dormidas; i++) {
+    operaciones.push_back({'T', activas + i, uniforme(generador), 1});
+  }
+
+  return operaciones;
+}
+
+bool grabar(const string& archivo, const vector<Operacion>& operaciones) {
+  ofstream salida(archivo);
+  if (!salida) {
+    return false;
+  }
+
+  salida << "loadgen-traza 1\n";
+  for (const Operacion& op : operaciones) {
+    salida << op.tipo;
+    if (op.tipo == 'T') {
+      salida << ' ' << op.origen << ' ' << op.destino << ' ' << op.monto;
+    }
+    salida << '\n';
+  }
+  return static_cast<bool>(salida);
+}
+
+bool leer(const string& archivo, vector<Operacion>& operaciones) {
+  ifstream entrada(archivo);
+  string encabezado;
+  if (!entrada || !getline(entrada, encabezado) || encabezado != "loadgen-traza 1") {
+    return false;
+  }
+
+  Operacion op = {0, 0, 0, 0};
+  while (entrada >> op.tipo) {
+    if (op.tipo == 'T' && !(entrada >> op.origen >> op.destino >> op.monto)) {
+      return false;
+    }
+    if (op.tipo != 'A' && op.tipo != 'T' && op.tipo != 'D' && op.tipo != 'M') {
+      return false;
+    }
+    operaciones.push_back(op);
+  }
+  return true;
+}
+
+void reportar(const string& nombre, vector<double>& latencias, double segundos) {
+  if (latencias.empty()) {
+    return;
+  }
+
+  sort(latencias.begin(), latencias.end());
+  auto percentil = [&](double p) {
+    return latencias[min(latencias.size() - 1, static_cast<size_t>(p * latencias.size()))];
+  };
+
+  cout << nombre << ": " << latencias.size() << " ops, "
+       << latencias.size() / segundos << " ops/s, latencia (ns)"
+       << " p50=" << percentil(0.50)
+       << " p90=" << percentil(0.90)
+       << " p99=" << percentil(0.99)
+       << " p99.9=" << percentil(0.999)
+       << " max=" << latencias.back() << endl;
+}
+
+template <class Politica>
+void ejecutar(const vector<Operacion>& operaciones) {
+  RelojManual reloj(0);
+  BlockchainGenerica<Politica> blockchain(&reloj);
+  vector<BilleteraGenerica<Politica>*> billeteras;
+
+  vector<double> latencias_abrir;
+  vector<double> latencias_transferir;
+  double segundos_abrir = 0;
+  double segundos_transferir = 0;
+  size_t rechazadas = 0;
+
+  for (const Operacion& op : operaciones) {
+    if (op.tipo == 'D') {
+      reloj.avanzar_un_dia();
+    } else if (op.tipo == 'M') {
+      reloj.avanzar_un_minuto();
+    } else if (op.tipo == 'A') {
+      auto inicio = chrono::steady_clock::now();
+      billeteras.push_back(blockchain.abrir_billetera());
+      chrono::duration<double> duracion = chrono::steady_clock::now() - inicio;
+      segundos_abrir += duracion.count();
+      latencias_abrir.push_back(duracion.count() * 1e9);
+    } else if (op.origen < billeteras.size() && op.destino < billeteras.size()) {
+      auto inicio = chrono::steady_clock::now();
+      bool aprobada = blockchain.agregar_transaccion(billeteras[op.origen], billeteras[op.destino]->id(), op.monto);
+      chrono::duration<double> duracion = chrono::steady_clock::now() - inicio;
+      segundos_transferir += duracion.count();
+      latencias_transferir.push_back(duracion.count() * 1e9);
+      rechazadas += !aprobada;
+    }
+  }
+
+  reportar("abrir_billetera", latencias_abrir, segundos_abrir);
+  reportar("agregar_transaccion", latencias_transferir, segundos_transferir);
+  cout << "transacciones rechazadas: " << rechazadas << endl;
+}
+
+bool leer_opciones(int argc, char** argv, Opciones& opciones) {
+  for (int i = 1; i < argc; i++) {
+    string opcion = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    string valor = argv[++i];
+
+    if (opcion == "--billeteras") opciones.billeteras = stoul(valor);
+    else if (opcion == "--transacciones") opciones.transacciones = stoul(valor);
+    else if (opcion == "--destinatarios") opciones.destinatarios = valor;
+    else if (opcion == "--zipf-s") opciones.zipf_s = stod(valor);
+    else if (opcion == "--dormidas") opciones.dormidas = stod(valor);
+    else if (opcion == "--transacciones-por-dia") opciones.transacciones_por_dia = max(1ul, stoul(valor));
+    else if (opcion == "--semilla") opciones.semilla = stoul(valor);
+    else if (opcion == "--politica") opciones.politica = valor;
+    else if (opcion == "--grabar") opciones.grabar = valor;
+    else if (opcion == "--reproducir") opciones.reproducir = valor;
+    else return false;
+  }
+
+  // Hacen falta dos billeteras activas para generar transferencias.
+  return opciones.billeteras >= 2
+      && (opciones.destinatarios == "uniforme" || opciones.destinatarios == "zipf")
+      && (opciones.politica == "completa" || opciones.politica == "solo_saldo");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Opciones opciones;
+  if (!leer_opciones(argc, argv, opciones)) {
+    cerr << "opciones inválidas, ver el comentario al principio de bench/loadgen.cpp" << endl;
+    return 1;
+  }
+
+  // Los ids de las billeteras salen de rand(), los fijo para que sean reproducibles.
+  srand(static_cast<unsigned int>(opciones.semilla));
+
+  vector<Operacion> operaciones;
+  if (!opciones.reproducir.empty()) {
+    if (!leer(opciones.reproducir, operaciones)) {
+      cerr << "no se pudo leer la traza " << opciones.reproducir << endl;
+      return 1;
+    }
+  } else {
+    operaciones = generar(opciones);
+  }
+
+  if (!opciones.grabar.empty() && !grabar(opciones.grabar, operaciones)) {
+    cerr << "no se pudo grabar la traza " << opciones.grabar << endl;
+    return 1;
+  }
+
+  if (opciones.politica == "solo_saldo") {
+    ejecutar<PoliticaSoloSaldo>(operaciones);
+  } else {
+    ejecutar<PoliticaCompleta>(operaciones);
+  }
+
+  return 0;
+}
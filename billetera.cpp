@@ -1,24 +1,33 @@
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
 #include <vector>
 
 #include "lib.h"
-#include "calendario.h"
 #include "billetera.h"
 #include "blockchain.h"
 
 using namespace std;
 
-Billetera::Billetera(const id_billetera id, Blockchain* blockchain)
+template <class Politica>
+BilleteraGenerica<Politica>::BilleteraGenerica(const id_billetera id, BlockchainGenerica<Politica>* blockchain)
   : _id(id)
   , _blockchain(blockchain)
   , _saldo(0)
-  , _dia_apertura(-1)
-{}
+{
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    _dia_apertura = -1;
+    _posicion_contigua = 0;
+  }
+}
 
-id_billetera Billetera::id() const {                                                    // Función: O(1)
+template <class Politica>
+id_billetera BilleteraGenerica<Politica>::id() const {                                                    // Función: O(1)
   return _id;                                                                           // O(1)
 }
 
-void Billetera::notificar_transaccion(Transaccion t) {                                  // Función: O(D + C)
+template <class Politica>
+void BilleteraGenerica<Politica>::notificar_transaccion(Transaccion t, int dia) {       // Función: O(D + C)
   /*
    * Necesito:
    *  - Actualizar el saldo actual.
@@ -26,57 +35,85 @@ void Billetera::notificar_transaccion(Transaccion t) {
    *  - Actualizar el saldo del dia de la transaccion.
    *  - Aumentar el número de transacciones al destinatario.
    *  - Ordenar las transacciones por destinatario en orden descendiente.
+   *
+   * Cada paso sólo se compila si la política habilita la estructura que actualiza.
    */
 
-  // Si es la primera transferencia, guarda el dia de apertura de la billetera.
-  if(_dia_apertura == -1) {                                                             // O(1)
-    _dia_apertura = t._timestamp/86400;                                                 // O(1)
-  }
+  int index = 0;                                                                        // O(1)
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    // Si es la primera transferencia, guarda el dia de apertura de la billetera.
+    if(_dia_apertura == -1) {                                                           // O(1)
+      _dia_apertura = dia;                                                              // O(1)
+    }
 
-  int dia_transferencia = t._timestamp/86400;                                           // O(1)
-  int index = dia_transferencia - _dia_apertura;                                        // O(1)
+    // Los días archivados no están en el vector del nivel caliente.
+    index = dia - _dia_apertura - (int)_saldos_frios.cantidad();                        // O(1)
 
-  // Agrega al vector el saldo de cada uno de los dias entre la ultima transferencia y la nueva.
-  while(index >= _saldo_al_fin_del_dia.size()) {                                        // O(1). D iteraciones => O(D)
-   _saldo_al_fin_del_dia.push_back(_saldo);                                             // O(1)
+    // Agrega al vector el saldo de cada uno de los dias entre la ultima transferencia y la nueva.
+    while(index >= _saldo_al_fin_del_dia.size()) {                                      // O(1). D iteraciones => O(D)
+     _saldo_al_fin_del_dia.push_back(_saldo);                                           // O(1)
+    }
   }
 
   if(t.origen == _id) {                                                                 // O(1)
     /* Actualizo el saldo actual. */
     _saldo -= t.monto;                                                                  // O(1)
     /* Actualizo el saldo del dia de la transaccion. */
-    _saldo_al_fin_del_dia[index] -= t.monto;                                            // O(1)
-    
-    /* Aumento el número de transacciones al destinatario. */
-    bool aumentado = false;                                                             // O(1)
-    int posicion_destinatario;                                                          // O(1)
-    
-    // Si el destinatario está en el vector, aumento su #transferencias.
-    for(int i = 0; i < _transferencias_por_destinatario.size(); ++i) {                  // O(1). C iteraciones => O(C)
-      if(_transferencias_por_destinatario[i].first == t.destino) {                      // O(1)
-        _transferencias_por_destinatario[i].second++;                                   // O(1)
-        posicion_destinatario = i;                                                      // O(1)
-        aumentado = true;                                                               // O(1)
-      }
+    if constexpr (Politica::SALDOS_DIARIOS) {
+      _saldo_al_fin_del_dia[index] -= t.monto;                                          // O(1)
     }
 
-    // Si no está en el vector, lo agrego al final.
-    if(!aumentado) {
-      pair<id_billetera,int> nuevo_destinatario;                                        // O(1)
-      nuevo_destinatario.first = t.destino;                                             // O(1)
-      nuevo_destinatario.second = 1;                                                    // O(1)
-      _transferencias_por_destinatario.push_back(nuevo_destinatario);                   // O(1)
-      posicion_destinatario = _transferencias_por_destinatario.size()-1;                // O(1)
+    if constexpr (Politica::RANKING) {
+      /* Aumento el número de transacciones al destinatario. */
+      bool aumentado = false;                                                           // O(1)
+      int posicion_destinatario;                                                        // O(1)
+
+      // Si el destinatario está en el vector, aumento su #transferencias.
+      for(int i = 0; i < _transferencias_por_destinatario.size(); ++i) {                // O(1). C iteraciones => O(C)
+        if(_transferencias_por_destinatario[i].first == t.destino) {                    // O(1)
+          _transferencias_por_destinatario[i].second++;                                 // O(1)
+          posicion_destinatario = i;                                                    // O(1)
+          aumentado = true;                                                             // O(1)
+        }
+      }
+
+      // Si no está en el vector, lo agrego al final.
+      if(!aumentado) {
+        pair<id_billetera,int> nuevo_destinatario;                                      // O(1)
+        nuevo_destinatario.first = t.destino;                                           // O(1)
+        nuevo_destinatario.second = 1;                                                  // O(1)
+        _transferencias_por_destinatario.push_back(nuevo_destinatario);                 // O(1)
+        posicion_destinatario = _transferencias_por_destinatario.size()-1;              // O(1)
+      }
+
+      /* Ordeno las transacciones por destinatario en orden descendiente. */
+      // Implementamos el algoritmo BubbleSort modificado, para ubicar al destinatario
+      // de manera descendente con respecto a #transferencias y creciente en antiguedad.
+
+      while(posicion_destinatario != 0 && _transferencias_por_destinatario[posicion_destinatario-1].second <= _transferencias_por_destinatario[posicion_destinatario].second) {
+        // O(1). C iteraciones en el peor caso => O(C).
+        swap(_transferencias_por_destinatario[posicion_destinatario-1],_transferencias_por_destinatario[posicion_destinatario]);  // O(1)
+        posicion_destinatario--;                                                        // O(1)
+      }
     }
 
-    /* Ordeno las transacciones por destinatario en orden descendiente. */
-    // Implementamos el algoritmo BubbleSort modificado, para ubicar al destinatario
-    // de manera descendente con respecto a #transferencias y creciente en antiguedad.
-  
-    while(posicion_destinatario != 0 && _transferencias_por_destinatario[posicion_destinatario-1].second <= _transferencias_por_destinatario[posicion_destinatario].second) {
-      // O(1). C iteraciones en el peor caso => O(C).
-      swap(_transferencias_por_destinatario[posicion_destinatario-1],_transferencias_por_destinatario[posicion_destinatario]);  // O(1)
-      posicion_destinatario--;                                                          // O(1)
+    if constexpr (Politica::RANKING_HISTORICO) {
+      /* Registro la salida y, cada tanto, un checkpoint del ranking. */
+      _salidas.push_back({t._timestamp, t.destino});                                    // O(1)
+      size_t ultimo_checkpoint = _checkpoints_ranking.empty() ? 0 : _checkpoints_ranking.back().salidas;  // O(1)
+
+      // El checkpoint cuesta O(C*log(C)) y se toma cada C salidas o mas => O(log(C)) amortizado.
+      if(_salidas.size() - ultimo_checkpoint >= max(INTERVALO_MINIMO_CHECKPOINT, _transferencias_por_destinatario.size())) {
+        CheckpointRanking checkpoint;                                                   // O(1)
+        checkpoint.salidas = _salidas.size();                                           // O(1)
+        checkpoint.ranking = _transferencias_por_destinatario;                          // O(C)
+        checkpoint.por_id.resize(checkpoint.ranking.size());                            // O(C)
+        iota(checkpoint.por_id.begin(), checkpoint.por_id.end(), 0);                    // O(C)
+        sort(checkpoint.por_id.begin(), checkpoint.por_id.end(), [&](unsigned int a, unsigned int b) {
+          return checkpoint.ranking[a].first < checkpoint.ranking[b].first;
+        });                                                                             // O(C*log(C))
+        _checkpoints_ranking.push_back(std::move(checkpoint));                         // O(1)
+      }
     }
   
     // Complejidad del if: O(1)*14 + O(C)*2 
@@ -86,7 +123,9 @@ void Billetera::notificar_transaccion(Transaccion t) {
     // = O(C)
   } else {
     _saldo += t.monto;                                                                  // O(1)
-    _saldo_al_fin_del_dia[index] += t.monto;                                            // O(1)
+    if constexpr (Politica::SALDOS_DIARIOS) {
+      _saldo_al_fin_del_dia[index] += t.monto;                                          // O(1)
+    }
 
     // Complejidad del else: O(1)*2
     // Prop: k.f1 ∈ O(g1), f1 ∈ O(g1)
@@ -94,7 +133,9 @@ void Billetera::notificar_transaccion(Transaccion t) {
   }
 
   /* Agrego la transacción a las ultimas transacciones. */
-  _ultimas_transacciones.push_back(t);                                                  // O(1)
+  if constexpr (Politica::HISTORIAL) {
+    _ultimas_transacciones.push_back(t);                                                // O(1)
+  }
 
   // Complejidad de la función:
   // O(1)*6 + O(D) + O(C)
@@ -102,16 +143,49 @@ void Billetera::notificar_transaccion(Transaccion t) {
   // = O(1) + O(D) + O(C)
   // f1 + f2 ∈ O(max{g1,g2}), f1 ∈ O(g1), f2 ∈ O(g2).
   // = O(D + C)
+  //
+  // Con PoliticaSoloSaldo sólo queda la actualización del saldo: O(1).
 }
 
 
-monto Billetera::saldo() const {                                                        // Función: O(1)
+template <class Politica>
+void BilleteraGenerica<Politica>::registrar_semilla(Transaccion semilla, int dia) {      // Función: O(1)
+  _saldo = semilla.monto;                                                               // O(1)
+
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    _dia_apertura = dia;                                                                // O(1)
+    _saldo_al_fin_del_dia.push_back(_saldo);                                            // O(1)
+  }
+
+  if constexpr (Politica::HISTORIAL) {
+    _ultimas_transacciones.push_back(semilla);                                          // O(1)
+  }
+}
+
+template <class Politica>
+monto BilleteraGenerica<Politica>::saldo() const {                                      // Función: O(1)
   return _saldo;                                                                        // O(1)
 }
 
-monto Billetera::saldo_al_fin_del_dia(timestamp t) const {                              // Función: O(1)
-  int dia_chequear = (Calendario::principio_del_dia(t))/86400;                          // O(1)
-  int dia_desde_apertura = dia_chequear - _dia_apertura;                                // O(1)
+template <class Politica>
+monto BilleteraGenerica<Politica>::saldo_al_fin_del_dia(timestamp t) const requires Politica::SALDOS_DIARIOS {  // Función: O(log(D))
+  // Uno por hilo: no ocupa memoria en cada billetera y las consultas concurrentes no se pisan.
+  thread_local DiaEnCurso dia_consultado;                                               // O(1)
+  return saldo_al_fin_del_dia_indice(dia_consultado.indice(t));                         // O(log(D))
+}
+
+template <class Politica>
+monto BilleteraGenerica<Politica>::saldo_al_fin_del_dia_indice(int dia) const requires Politica::SALDOS_DIARIOS {  // Función: O(log(D))
+  int dia_desde_apertura = dia - _dia_apertura;                                         // O(1)
+
+  // Si el dia es anterior a la apertura, la billetera todavia no existia.
+  if(dia_desde_apertura < 0) return 0;                                                  // O(1)
+
+  // Si el dia esta archivado, lo busco en el nivel frio.
+  if(dia_desde_apertura < (int)_saldos_frios.cantidad()) {                              // O(1)
+    return _saldos_frios.consultar(dia_desde_apertura);                                 // O(log(D))
+  }
+  dia_desde_apertura -= _saldos_frios.cantidad();                                       // O(1)
 
   // Si el ultimo indice del vector de saldos es menor que el dia a chequear, significa que el dia no esta
   // registrado en el vector de saldos y entonces devolvemos el ultimo saldo registrado.
@@ -123,11 +197,17 @@ monto Billetera::saldo_al_fin_del_dia(timestamp t) const {
   // = O(1)
 }
 
-vector<Transaccion> Billetera::ultimas_transacciones(int k) const {                     // Función: O(K)
+template <class Politica>
+vector<Transaccion> BilleteraGenerica<Politica>::ultimas_transacciones(int k) const requires Politica::HISTORIAL {  // Función: O(K)
   vector<Transaccion> primerasKtransacc;                                                // O(1)
   for(int i = 0; i < _ultimas_transacciones.size() && i < k; ++i) {                     // O(1). K iteraciones => O(K)
     primerasKtransacc.push_back(_ultimas_transacciones[_ultimas_transacciones.size()-1-i]); // O(1)
   }
+
+  // Si se piden mas de las que hay en el nivel caliente, completo con el nivel frio.
+  if(k > (int)primerasKtransacc.size()) {                                               // O(1)
+    _transacciones_frias.ultimas(k - primerasKtransacc.size(), _id, primerasKtransacc);  // O(K + bloque)
+  }
   
   return primerasKtransacc;                                                             // O(1)
 
@@ -138,7 +218,8 @@ vector<Transaccion> Billetera::ultimas_transacciones(int k) const {
   // = O(K)
 }
 
-vector<id_billetera> Billetera::detinatarios_mas_frecuentes(int k) const {              // Función: O(K)
+template <class Politica>
+vector<id_billetera> BilleteraGenerica<Politica>::detinatarios_mas_frecuentes(int k) const requires Politica::RANKING {  // Función: O(K)
   vector<id_billetera> primerosKdestinatarios;                                          // O(1)
   for(int i = 0; i < _transferencias_por_destinatario.size() && i < k; i++) {           // O(1). K iteraciones => O(K)
     primerosKdestinatarios.push_back(_transferencias_por_destinatario[i].first);        // O(1)
@@ -150,4 +231,203 @@ vector<id_billetera> Billetera::detinatarios_mas_frecuentes(int k) const {
   // O(1) + O(K)
   // f1 + f2 ∈ O(max{g1,g2}), f1 ∈ O(g1), f2 ∈ O(g2).
   // = O(K)
-}
\ No newline at end of file
+}
+
+template <class Politica>
+vector<Transaccion> BilleteraGenerica<Politica>::ultimas_transacciones_al(timestamp t, int k) const requires Politica::HISTORIAL {  // Función: O(log(H) + K)
+  vector<Transaccion> resultado;                                                        // O(1)
+  if(k <= 0) return resultado;                                                          // O(1)
+
+  // Primera transaccion del nivel caliente posterior a `t`.
+  auto fin = upper_bound(_ultimas_transacciones.begin(), _ultimas_transacciones.end(), t,
+    [](timestamp t, const Transaccion& tx) { return t < tx._timestamp; });              // O(log(H))
+
+  for(auto it = fin; it != _ultimas_transacciones.begin() && (int)resultado.size() < k; ) {  // K iteraciones => O(K)
+    --it;                                                                               // O(1)
+    resultado.push_back(*it);                                                           // O(1)
+  }
+
+  // Si no alcanzo, sigo por el nivel frio, que es anterior a todo el caliente.
+  size_t faltan = k - resultado.size();                                                 // O(1)
+  if(faltan > 0) {
+    if(fin == _ultimas_transacciones.begin()) {
+      _transacciones_frias.ultimas_hasta(t, faltan, _id, resultado);                    // O(log(H) + K + bloque)
+    } else {
+      _transacciones_frias.ultimas(faltan, _id, resultado);                             // O(K + bloque)
+    }
+  }
+
+  return resultado;                                                                     // O(1)
+}
+
+template <class Politica>
+vector<id_billetera> BilleteraGenerica<Politica>::detinatarios_mas_frecuentes_al(timestamp t, int k) const requires Politica::RANKING_HISTORICO {  // Función: O(log(S) + I*log(C) + K)
+  /*
+   * El ranking ordena por #transferencias descendente y, a igual cantidad,
+   * primero al que recibio la ultima transferencia mas reciente (ver
+   * notificar_transaccion). Entonces, partiendo de un checkpoint:
+   *  - los destinatarios que no recibieron transferencias desde el checkpoint
+   *    conservan su orden relativo;
+   *  - los que si recibieron son mas recientes que todos los anteriores, asi
+   *    que van antes que cualquiera de ellos con igual o menor cantidad.
+   * Alcanza con ordenar los tocados e intercalarlos con el checkpoint.
+   */
+  vector<id_billetera> resultado;                                                       // O(1)
+
+  // Cantidad de salidas hasta `t`.
+  size_t salidas = upper_bound(_salidas.begin(), _salidas.end(), t,
+    [](timestamp t, const pair<timestamp,id_billetera>& s) { return t < s.first; }) - _salidas.begin();  // O(log(S))
+
+  // Ultimo checkpoint que refleja a lo sumo esas salidas.
+  auto siguiente = upper_bound(_checkpoints_ranking.begin(), _checkpoints_ranking.end(), salidas,
+    [](size_t salidas, const CheckpointRanking& c) { return salidas < c.salidas; });    // O(log(S))
+  const CheckpointRanking* checkpoint = siguiente == _checkpoints_ranking.begin() ? nullptr : &*(siguiente - 1);  // O(1)
+  size_t desde = checkpoint == nullptr ? 0 : checkpoint->salidas;                       // O(1)
+
+  // Para cada destinatario tocado: #transferencias al momento `t` y ultima salida.
+  unordered_map<id_billetera, pair<int,size_t>> tocados;                                // O(1)
+  for(size_t i = desde; i < salidas; i++) {                                             // I iteraciones => O(I*log(C))
+    id_billetera destino = _salidas[i].second;                                          // O(1)
+    auto tocado = tocados.find(destino);                                                // O(1)
+    if(tocado == tocados.end()) {
+      int previas = 0;                                                                  // O(1)
+      if(checkpoint != nullptr) {
+        auto pos = lower_bound(checkpoint->por_id.begin(), checkpoint->por_id.end(), destino,
+          [&](unsigned int p, id_billetera id) { return checkpoint->ranking[p].first < id; });  // O(log(C))
+        if(pos != checkpoint->por_id.end() && checkpoint->ranking[*pos].first == destino) {
+          previas = checkpoint->ranking[*pos].second;                                   // O(1)
+        }
+      }
+      tocado = tocados.insert({destino, {previas, 0}}).first;                           // O(1)
+    }
+    tocado->second.first++;                                                             // O(1)
+    tocado->second.second = i;                                                          // O(1)
+  }
+
+  vector<pair<id_billetera, pair<int,size_t>>> ordenados(tocados.begin(), tocados.end());  // O(I)
+  sort(ordenados.begin(), ordenados.end(), [](const auto& a, const auto& b) {
+    return a.second.first != b.second.first ? a.second.first > b.second.first : a.second.second > b.second.second;
+  });                                                                                   // O(I*log(I))
+
+  // Intercalo los tocados con el checkpoint, salteando del checkpoint a los tocados.
+  size_t i = 0;                                                                         // O(1)
+  size_t j = 0;                                                                         // O(1)
+  size_t total = checkpoint == nullptr ? 0 : checkpoint->ranking.size();                // O(1)
+  while((int)resultado.size() < k) {                                                    // K + I iteraciones => O(K + I)
+    while(i < total && tocados.count(checkpoint->ranking[i].first)) i++;                // O(1)
+
+    if(j < ordenados.size() && (i == total || ordenados[j].second.first >= checkpoint->ranking[i].second)) {
+      resultado.push_back(ordenados[j++].first);                                        // O(1)
+    } else if(i < total) {
+      resultado.push_back(checkpoint->ranking[i++].first);                              // O(1)
+    } else {
+      break;
+    }
+  }
+
+  return resultado;                                                                     // O(1)
+}
+
+template <class Politica>
+void BilleteraGenerica<Politica>::archivar(timestamp limite) {                          // Función: O(H + D)
+  if constexpr (Politica::HISTORIAL) {
+    // Las transacciones estan ordenadas cronologicamente, archivo el prefijo anterior a `limite`.
+    size_t cantidad = 0;                                                                // O(1)
+    while(cantidad < _ultimas_transacciones.size() && _ultimas_transacciones[cantidad]._timestamp < limite) {  // O(H)
+      cantidad++;                                                                       // O(1)
+    }
+
+    if(cantidad > 0) {
+      _transacciones_frias.agregar(_ultimas_transacciones, cantidad, _id);              // O(H)
+      _ultimas_transacciones.erase(_ultimas_transacciones.begin(), _ultimas_transacciones.begin() + cantidad);  // O(H)
+      _ultimas_transacciones.shrink_to_fit();                                           // O(H)
+    }
+  }
+
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    if(_dia_apertura == -1) return;                                                     // O(1)
+
+    // Dias del nivel caliente anteriores al dia de `limite`, sin incluir el ultimo.
+    int dia_limite = (int)(limite/86400) - _dia_apertura - (int)_saldos_frios.cantidad();  // O(1)
+    int ultimo = _saldo_al_fin_del_dia.size() - 1;                                      // O(1)
+    int cantidad = min(dia_limite, ultimo);                                             // O(1)
+
+    if(cantidad > 0) {
+      _saldos_frios.agregar(_saldo_al_fin_del_dia, cantidad);                           // O(D)
+      _saldo_al_fin_del_dia.erase(_saldo_al_fin_del_dia.begin(), _saldo_al_fin_del_dia.begin() + cantidad);  // O(D)
+      _saldo_al_fin_del_dia.shrink_to_fit();                                            // O(D)
+    }
+  }
+}
+
+template <class Politica>
+EstadisticasMemoria BilleteraGenerica<Politica>::estadisticas_memoria() const {         // Función: O(P)
+  EstadisticasMemoria estadisticas;                                                     // O(1)
+
+  if constexpr (Politica::HISTORIAL) {
+    estadisticas.transacciones_calientes = _ultimas_transacciones.size();               // O(1)
+    estadisticas.transacciones_frias = _transacciones_frias.cantidad();                 // O(1)
+    estadisticas.bytes_calientes += _ultimas_transacciones.capacity() * sizeof(Transaccion);  // O(1)
+    estadisticas.bytes_frios += _transacciones_frias.bytes();                           // O(1)
+  }
+
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    estadisticas.dias_calientes = _saldo_al_fin_del_dia.size();                         // O(1)
+    estadisticas.dias_frios = _saldos_frios.cantidad();                                 // O(1)
+    estadisticas.bytes_calientes += _saldo_al_fin_del_dia.capacity() * sizeof(monto);   // O(1)
+    estadisticas.bytes_frios += _saldos_frios.bytes();                                  // O(1)
+  }
+
+  // El ranking no tiene nivel frío: se cuenta aparte y siempre está en memoria.
+  if constexpr (Politica::RANKING) {
+    estadisticas.bytes_ranking += _transferencias_por_destinatario.capacity() * sizeof(pair<id_billetera,int>);  // O(1)
+  }
+
+  if constexpr (Politica::RANKING_HISTORICO) {
+    estadisticas.bytes_ranking += _salidas.capacity() * sizeof(pair<timestamp,id_billetera>);  // O(1)
+    estadisticas.bytes_ranking += _checkpoints_ranking.capacity() * sizeof(CheckpointRanking);  // O(1)
+    for(const CheckpointRanking& checkpoint : _checkpoints_ranking) {                   // O(1). P iteraciones => O(P)
+      estadisticas.bytes_ranking += checkpoint.ranking.capacity() * sizeof(pair<id_billetera,int>);  // O(1)
+      estadisticas.bytes_ranking += checkpoint.por_id.capacity() * sizeof(unsigned int);  // O(1)
+    }
+  }
+
+  return estadisticas;                                                                  // O(1)
+}
+
+template <class Politica>
+void BilleteraGenerica<Politica>::liberar_estado() {                                    // Función: O(H + D + C)
+  // Intercambio con estructuras vacias para devolver la memoria, clear() conserva la capacidad.
+  if constexpr (Politica::HISTORIAL) {
+    vector<Transaccion>().swap(_ultimas_transacciones);                                 // O(H)
+    _transacciones_frias = TransaccionesComprimidas();                                  // O(H)
+  }
+
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    vector<monto>().swap(_saldo_al_fin_del_dia);                                        // O(D)
+    _saldos_frios = SaldosComprimidos();                                                // O(D)
+  }
+
+  if constexpr (Politica::RANKING) {
+    vector<pair<id_billetera,int>>().swap(_transferencias_por_destinatario);            // O(C)
+  }
+
+  if constexpr (Politica::RANKING_HISTORICO) {
+    vector<pair<timestamp,id_billetera>>().swap(_salidas);                              // O(S)
+    vector<CheckpointRanking>().swap(_checkpoints_ranking);                             // O(S)
+  }
+}
+
+template <class Politica>
+size_t BilleteraGenerica<Politica>::posicion_contigua() const requires Politica::SALDOS_DIARIOS { // Función: O(1)
+  return _posicion_contigua;                                                            // O(1)
+}
+
+template <class Politica>
+void BilleteraGenerica<Politica>::fijar_posicion_contigua(size_t posicion) requires Politica::SALDOS_DIARIOS { // Función: O(1)
+  _posicion_contigua = posicion;                                                        // O(1)
+}
+
+// Instanciaciones explícitas de las políticas provistas en politicas.h.
+template class BilleteraGenerica<PoliticaCompleta>;
+template class BilleteraGenerica<PoliticaSoloSaldo>;
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include "lib.h"
+#include "politicas.h"
+#include "historial_frio.h"
 #include "blockchain.h"
 
 using namespace std;
@@ -19,15 +21,40 @@ using namespace std;
  *  - Las transferencias por destinatario están ordenadas decrecientemente. 
  *  - La suma de las transferencias por destinatario es igual a la cantidad de transacciones. 
  *  - Todos los ids a los que se les envió dinero están incluidos en transf por destinatarios. 
+ *
+ * Los invariantes sobre cada estructura sólo aplican si la `Politica` la habilita
+ * (ver politicas.h).
+ *
+ * Las últimas transacciones y los saldos al fin de cada día se guardan en dos
+ * niveles: los más antiguos comprimidos en el nivel frío (ver `archivar`) y el
+ * resto en los vectores del nivel caliente. Los invariantes de arriba aplican
+ * a la concatenación de ambos niveles, y el nivel caliente de saldos nunca
+ * queda vacío.
  */
 
-class Billetera {
+/**
+ * Copia del ranking de destinatarios de una billetera después de sus primeras
+ * `salidas` transferencias enviadas.
+ */
+struct CheckpointRanking {
+  /** Cantidad de transferencias enviadas que refleja el checkpoint. */
+  size_t salidas;
+
+  /** Transferencias por destinatario, en el orden del ranking. */
+  vector<pair<id_billetera,int>> ranking;
+
+  /** Posiciones de `ranking` ordenadas por id de destinatario. */
+  vector<unsigned int> por_id;
+};
+
+template <class Politica>
+class BilleteraGenerica {
   public:
     /**
      * Constructor. No se utiliza directamente, si no que se asume que será
      * llamado por la blockchain al utilizar el método `abrir_billetera`.
      */
-    Billetera(const id_billetera id, Blockchain* blockchain);
+    BilleteraGenerica(const id_billetera id, BlockchainGenerica<Politica>* blockchain);
 
     /**
      *  Retorna el id de la billetera, asignado al momento de su creación.
@@ -40,11 +67,27 @@ class Billetera {
      *
      * Este método también es notificado al registrarse la transacción semilla.
      *
+     * `dia` es el índice del día de la transacción (`t._timestamp` / 86400).
+     * Lo calcula la blockchain, que mantiene los límites del día en curso (ver
+     * `DiaEnCurso`), así no se divide en cada notificación.
+     *
      * Complejidad esperada: O(D*log(D) + C), donde:
      *   - D es la máxima cantidad de días que una billetera estuvo activa
      *   - C es la máxima cantidad de destinatarios totales a los que una billetera envió dinero
      */
-    void notificar_transaccion(Transaccion t);
+    void notificar_transaccion(Transaccion t, int dia);
+
+    /**
+     * Inicializa el estado de una billetera recién creada a partir de su
+     * transacción semilla, sin pasar por `notificar_transaccion`. Lo usa la
+     * blockchain en `abrir_billeteras`.
+     *
+     * Se asume como precondición que la billetera no fue notificada de
+     * ninguna transacción. `dia` es el índice del día de la semilla.
+     *
+     * Complejidad: O(1)
+     */
+    void registrar_semilla(Transaccion semilla, int dia);
 
     /**
      * Devuelve el saldo actual de la billetera.
@@ -59,51 +102,174 @@ class Billetera {
      * Por ejemplo, si t es el 10 de enero a las 15hs, devolveremos el saldo que
      * tenía la billetera al fin del 10 de enero.
      *
-     * Se asume como precondición que t es mayor o igual al momento de la
-     * creación de la billetera.
+     * Si t es anterior al día de la creación de la billetera, devuelve 0.
+     *
+     * El índice del día se obtiene con un `DiaEnCurso` por hilo, así que
+     * consultas seguidas sobre el mismo día no dividen.
      *
      * Complejidad esperada: O(log(D)), donde D es la máxima cantidad de días
      * que una billetera estuvo activa
+     *
+     * Requiere que la política habilite SALDOS_DIARIOS.
      */
-    monto saldo_al_fin_del_dia(timestamp t) const;
+    monto saldo_al_fin_del_dia(timestamp t) const requires Politica::SALDOS_DIARIOS;
+
+    /**
+     * Igual que `saldo_al_fin_del_dia`, pero recibe el índice del día
+     * (t / 86400) ya calculado. Lo usa la blockchain para consultar muchas
+     * billeteras sobre el mismo día calculando el índice una sola vez.
+     *
+     * Complejidad esperada: O(log(D))
+     *
+     * Requiere que la política habilite SALDOS_DIARIOS.
+     */
+    monto saldo_al_fin_del_dia_indice(int dia) const requires Politica::SALDOS_DIARIOS;
 
     /**
      * Devuelve las últimas `k` transaccionesen las que esta billetera participó
      * (ya sea como origen o destino). Incluye la transacción semilla.
      *
      * Complejidad esperada: O(k)
+     *
+     * Requiere que la política habilite HISTORIAL.
      */
-    vector<Transaccion> ultimas_transacciones(int k) const;
+    vector<Transaccion> ultimas_transacciones(int k) const requires Politica::HISTORIAL;
 
     /**
      * Devuelve los ids de las `k` billeteras a las que más transacciones le
      * realizó esta billetera.
      *
      * Complejidad esperada: O(k)
+     *
+     * Requiere que la política habilite RANKING.
+     */
+    vector<id_billetera> detinatarios_mas_frecuentes(int k) const requires Politica::RANKING;
+
+    /**
+     * Devuelve lo que habría devuelto `ultimas_transacciones(k)` al momento
+     * `t`, es decir, las últimas `k` transacciones con timestamp menor o igual
+     * a `t`.
+     *
+     * Complejidad esperada: O(log(H) + k), donde H es la cantidad de
+     * transacciones de la billetera
+     *
+     * Requiere que la política habilite HISTORIAL.
+     */
+    vector<Transaccion> ultimas_transacciones_al(timestamp t, int k) const requires Politica::HISTORIAL;
+
+    /**
+     * Devuelve lo que habría devuelto `detinatarios_mas_frecuentes(k)` al
+     * momento `t`. Parte del último checkpoint del ranking anterior a `t` y
+     * aplica las transferencias enviadas desde entonces.
+     *
+     * Los checkpoints se toman cada max(INTERVALO_MINIMO_CHECKPOINT, C)
+     * transferencias enviadas, de modo que su memoria total es proporcional a
+     * la cantidad de transferencias enviadas.
+     *
+     * Complejidad esperada: O(log(S) + I*log(C) + k), donde S es la cantidad
+     * de transferencias enviadas e I la cantidad aplicadas desde el checkpoint
+     * (a lo sumo max(INTERVALO_MINIMO_CHECKPOINT, C))
+     *
+     * Requiere que la política habilite RANKING_HISTORICO.
      */
-    vector<id_billetera> detinatarios_mas_frecuentes(int k) const;
+    vector<id_billetera> detinatarios_mas_frecuentes_al(timestamp t, int k) const requires Politica::RANKING_HISTORICO;
+
+    /**
+     * Mueve al nivel frío las transacciones anteriores a `limite` y los saldos
+     * de los días anteriores al de `limite`. El saldo del día de la última
+     * transacción siempre queda en el nivel caliente.
+     *
+     * Las consultas siguen devolviendo lo mismo; las que alcanzan el nivel
+     * frío lo descomprimen bajo demanda.
+     *
+     * Complejidad: O(H + D), donde H es la cantidad de transacciones y D la
+     * cantidad de días del nivel caliente
+     */
+    void archivar(timestamp limite);
+
+    /**
+     * Devuelve la memoria usada por el historial en cada nivel, y la del
+     * ranking de destinatarios, que no se archiva.
+     *
+     * Complejidad: O(P), donde P es la cantidad de checkpoints del ranking
+     */
+    EstadisticasMemoria estadisticas_memoria() const;
+
+    /**
+     * Libera la memoria de todas las estructuras derivadas (historial, saldos
+     * diarios y ranking, en ambos niveles). Lo usa la blockchain al cerrar la
+     * billetera; después de llamarlo sólo `id` y `saldo` son válidos.
+     *
+     * Complejidad: O(H + D + C)
+     */
+    void liberar_estado();
+
+    /**
+     * Posición de la billetera en la copia contigua del registro de su
+     * blockchain. La asigna y la mantiene la blockchain, que la usa para
+     * actualizar esa copia sin buscarla.
+     *
+     * Complejidad: O(1)
+     *
+     * Requiere que la política habilite SALDOS_DIARIOS.
+     */
+    size_t posicion_contigua() const requires Politica::SALDOS_DIARIOS;
+
+    /**
+     * Asigna la posición que devuelve `posicion_contigua`. Lo usa la
+     * blockchain al registrar la billetera y al compactar la copia contigua.
+     *
+     * Complejidad: O(1)
+     *
+     * Requiere que la política habilite SALDOS_DIARIOS.
+     */
+    void fijar_posicion_contigua(size_t posicion) requires Politica::SALDOS_DIARIOS;
 
   private:
     /** Id de la billetera */
     const id_billetera _id;
 
     /** Puntero a la blockchain asociada */
-    Blockchain* const _blockchain;
+    BlockchainGenerica<Politica>* const _blockchain;
 
     /** Saldo actualizado de la billetera */
     monto _saldo;
 
     /** Dia en que se abrio la billetera */
-    int _dia_apertura;
+    [[no_unique_address]] Opcional<Politica::SALDOS_DIARIOS, int> _dia_apertura;
+
+    /** Posicion en la copia contigua del registro de la blockchain */
+    [[no_unique_address]] Opcional<Politica::SALDOS_DIARIOS, size_t> _posicion_contigua;
 
     /** Lista las ultimas transacciones cronologicamente */
-    vector<Transaccion> _ultimas_transacciones;
+    [[no_unique_address]] Opcional<Politica::HISTORIAL, vector<Transaccion>> _ultimas_transacciones;
     
     /** Saldo al final de cada dia desde que se abrio la billetera hasta la ultima transaccion */
-    vector<monto> _saldo_al_fin_del_dia;
+    [[no_unique_address]] Opcional<Politica::SALDOS_DIARIOS, vector<monto>> _saldo_al_fin_del_dia;
+
+    /** Transacciones anteriores a las de `_ultimas_transacciones`, comprimidas */
+    [[no_unique_address]] Opcional<Politica::HISTORIAL, TransaccionesComprimidas> _transacciones_frias;
+
+    /** Saldos de los días anteriores a los de `_saldo_al_fin_del_dia`, comprimidos */
+    [[no_unique_address]] Opcional<Politica::SALDOS_DIARIOS, SaldosComprimidos> _saldos_frios;
 
     /** Cuantas transferencias se le realizo a todos los destinatarios (ordenadas) */
-    vector<pair<id_billetera,int>> _transferencias_por_destinatario;
+    [[no_unique_address]] Opcional<Politica::RANKING, vector<pair<id_billetera,int>>> _transferencias_por_destinatario;
+
+    /** Timestamp y destino de cada transferencia enviada, cronologicamente */
+    [[no_unique_address]] Opcional<Politica::RANKING_HISTORICO, vector<pair<timestamp,id_billetera>>> _salidas;
+
+    /** Checkpoints del ranking, en orden creciente de salidas */
+    [[no_unique_address]] Opcional<Politica::RANKING_HISTORICO, vector<CheckpointRanking>> _checkpoints_ranking;
+
+    /** Minima cantidad de transferencias enviadas entre dos checkpoints del ranking */
+    static constexpr size_t INTERVALO_MINIMO_CHECKPOINT = 64;
 };
 
+/** Billetera con todas las estructuras habilitadas. */
+using Billetera = BilleteraGenerica<PoliticaCompleta>;
+
+/** Billetera que sólo mantiene su saldo. */
+using BilleteraSoloSaldo = BilleteraGenerica<PoliticaSoloSaldo>;
+
 #endif
\ No newline at end of file
@@ -1,40 +1,156 @@
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
-#include "calendario.h"
 #include "blockchain.h"
 #include "billetera.h"
 
 using namespace std;
 
-Blockchain::Blockchain() {
+namespace {
+
+// Cantidad mínima de elementos por hilo para que valga la pena lanzarlo.
+const size_t MINIMO_POR_HILO = 4096;
+
+// Divide [0, n) en rangos contiguos y ejecuta `f(desde, hasta)` para cada uno
+// en su propio hilo. Con `hilos` en 0 usa los que tenga el equipo.
+//
+// Los hilos se crean y se esperan en cada llamada, sin reutilizarlos. Crear
+// uno cuesta del orden de decenas de microsegundos, que con MINIMO_POR_HILO
+// elementos por hilo es chico frente a lo que recorre.
+template <class F>
+void en_paralelo(size_t n, unsigned int hilos, F f) {
+  if (hilos == 0) {
+    hilos = max(1u, thread::hardware_concurrency());
+  }
+  hilos = static_cast<unsigned int>(min<size_t>(hilos, max<size_t>(1, n / MINIMO_POR_HILO)));
+
+  if (hilos == 1) {
+    f(0, n);
+    return;
+  }
+
+  vector<thread> trabajadores;
+  size_t por_hilo = (n + hilos - 1) / hilos;
+  for (size_t desde = por_hilo; desde < n; desde += por_hilo) {
+    trabajadores.emplace_back(f, desde, min(n, desde + por_hilo));
+  }
+  f(0, min(n, por_hilo));
+
+  for (thread& trabajador : trabajadores) {
+    trabajador.join();
+  }
+}
+
+} // namespace
+
+template <class Politica>
+BlockchainGenerica<Politica>::BlockchainGenerica() : BlockchainGenerica(RelojCalendario::global()) {}
+
+template <class Politica>
+BlockchainGenerica<Politica>::BlockchainGenerica(Reloj* reloj) {
+  _reloj = reloj;
   _transacciones = {};
   _billeteras = {};
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    _billeteras_contiguas_cerradas = 0;
+  }
+  _ultima_secuencia = 0;
 
   // sumo 1 porque el id 0 está reservado para las transacciones de saldo
   // inicial.
   _siguiente_id_billetera = static_cast<unsigned int>(rand()) + 1;
+  _paso_id_billetera = 1;
+}
+
+template <class Politica>
+BlockchainGenerica<Politica>::BlockchainGenerica(id_billetera primer_id, id_billetera paso, Reloj* reloj) {
+  _reloj = reloj == nullptr ? RelojCalendario::global() : reloj;
+  _transacciones = {};
+  _billeteras = {};
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    _billeteras_contiguas_cerradas = 0;
+  }
+  _ultima_secuencia = 0;
+  _siguiente_id_billetera = primer_id;
+  _paso_id_billetera = paso;
 }
 
-Billetera* Blockchain::abrir_billetera() {
-  Billetera * billetera = new Billetera(_siguiente_id_billetera, this);
+template <class Politica>
+BilleteraGenerica<Politica>* BlockchainGenerica<Politica>::abrir_billetera() {
+  BilleteraGenerica<Politica> * billetera = new BilleteraGenerica<Politica>(_siguiente_id_billetera, this);
   _billeteras[billetera->id()] = billetera;
-  _siguiente_id_billetera++;
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    billetera->fijar_posicion_contigua(_billeteras_contiguas.size());
+    _billeteras_contiguas.push_back({billetera->id(), 0, 0, billetera});
+  }
+  _siguiente_id_billetera += _paso_id_billetera;
 
-  Transaccion transaccion = {0, billetera->id(), SALDO_INICIAL, Calendario::tiempo_actual()};
+  Transaccion transaccion = {0, billetera->id(), SALDO_INICIAL, _reloj->ahora(), ++_ultima_secuencia};
+  int dia = _dia_en_curso.indice(transaccion._timestamp);
   _transacciones.push_back(transaccion);
-  billetera->notificar_transaccion(transaccion);
+  billetera->notificar_transaccion(transaccion, dia);
+  actualizar_contigua(billetera, dia);
 
   return billetera;
 }
 
-bool Blockchain::agregar_transaccion(Billetera* origen, id_billetera destino, double monto) {
+template <class Politica>
+vector<BilleteraGenerica<Politica>*> BlockchainGenerica<Politica>::abrir_billeteras(unsigned int n) {
+  vector<BilleteraGenerica<Politica>*> billeteras;
+  if (n == 0) {
+    return billeteras;
+  }
+  billeteras.reserve(n);
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    _billeteras_contiguas.reserve(_billeteras_contiguas.size() + n);
+  }
+
+  // Reservo el bloque completo antes de construir, así las direcciones de las
+  // billeteras no cambian.
+  _bloques_de_billeteras.push_back({{}, n});
+  vector<BilleteraGenerica<Politica>>& bloque = _bloques_de_billeteras.back().billeteras;
+  bloque.reserve(n);
+
+  timestamp ahora = _reloj->ahora();
+  int dia = _dia_en_curso.indice(ahora);
+  list<Transaccion> semillas;
+
+  for (unsigned int i = 0; i < n; i++) {
+    bloque.emplace_back(_siguiente_id_billetera, this);
+    BilleteraGenerica<Politica>* billetera = &bloque.back();
+    _siguiente_id_billetera += _paso_id_billetera;
+
+    Transaccion semilla = {0, billetera->id(), SALDO_INICIAL, ahora, ++_ultima_secuencia};
+    semillas.push_back(semilla);
+    billetera->registrar_semilla(semilla, dia);
+
+    // Los ids son mayores a todos los registrados, así que el hint al final
+    // hace la inserción O(1) amortizada.
+    _billeteras.emplace_hint(_billeteras.end(), billetera->id(), billetera);
+    if constexpr (Politica::SALDOS_DIARIOS) {
+      billetera->fijar_posicion_contigua(_billeteras_contiguas.size());
+      _billeteras_contiguas.push_back({billetera->id(), billetera->saldo(), dia, billetera});
+    }
+    billeteras.push_back(billetera);
+  }
+
+  _transacciones.splice(_transacciones.end(), semillas);
+
+  return billeteras;
+}
+
+template <class Politica>
+bool BlockchainGenerica<Politica>::agregar_transaccion(BilleteraGenerica<Politica>* origen, id_billetera destino, double monto) {
   auto origen_it = _billeteras.find(origen->id());
   auto destino_it = _billeteras.find(destino);
 
   bool billeteras_distintas = origen->id() != destino;
   bool origen_valido = origen_it != _billeteras.end() && origen_it->second == origen;
   bool destino_valido = destino_it != _billeteras.end();
-  bool saldo_suficiente = calcular_saldo(origen) >= monto;
+  auto reservado = _debitos_reservados.find(origen->id());
+  double monto_reservado = reservado == _debitos_reservados.end() ? 0 : reservado->second.monto;
+  bool saldo_suficiente = origen->saldo() >= monto + monto_reservado;
 
   bool transaccion_aprobada = billeteras_distintas && origen_valido && destino_valido && saldo_suficiente;
 
@@ -42,20 +158,282 @@ bool Blockchain::agregar_transaccion(Billetera* origen, id_billetera destino, do
     return false;
   }
 
-  Transaccion transaccion = {origen->id(), destino, monto, Calendario::tiempo_actual()};
+  if (hay_contrapresion()) {
+    return false;
+  }
+
+  Transaccion transaccion = {origen->id(), destino, monto, _reloj->ahora(), ++_ultima_secuencia};
+  int dia = _dia_en_curso.indice(transaccion._timestamp);
 
   _transacciones.push_back(transaccion);
-  origen_it->second->notificar_transaccion(transaccion);
-  destino_it->second->notificar_transaccion(transaccion);
+  origen_it->second->notificar_transaccion(transaccion, dia);
+  destino_it->second->notificar_transaccion(transaccion, dia);
+  actualizar_contigua(origen_it->second, dia);
+  actualizar_contigua(destino_it->second, dia);
+
+  return true;
+}
+
+template <class Politica>
+BilleteraGenerica<Politica>* BlockchainGenerica<Politica>::billetera(id_billetera id) const {
+  auto it = _billeteras.find(id);
+  return it == _billeteras.end() ? nullptr : it->second;
+}
+
+template <class Politica>
+timestamp BlockchainGenerica<Politica>::registrar(Transaccion transaccion, BilleteraGenerica<Politica>* billetera) {
+  transaccion._timestamp = max(transaccion._timestamp, ultimo_timestamp());
+  transaccion.secuencia = ++_ultima_secuencia;
+  int dia = _dia_en_curso.indice(transaccion._timestamp);
+  _transacciones.push_back(transaccion);
+  billetera->notificar_transaccion(transaccion, dia);
+  actualizar_contigua(billetera, dia);
+  return transaccion._timestamp;
+}
+
+template <class Politica>
+bool BlockchainGenerica<Politica>::reservar_debito(BilleteraGenerica<Politica>* origen, double monto) {
+  auto origen_it = _billeteras.find(origen->id());
+  if (origen_it == _billeteras.end() || origen_it->second != origen) {
+    return false;
+  }
+
+  DebitoReservado& reservado = _debitos_reservados[origen->id()];
+  if (origen->saldo() < reservado.monto + monto) {
+    if (reservado.cantidad == 0) {
+      _debitos_reservados.erase(origen->id());
+    }
+    return false;
+  }
+
+  reservado.monto += monto;
+  reservado.cantidad++;
+  return true;
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::cancelar_debito(id_billetera origen, double monto) {
+  auto it = _debitos_reservados.find(origen);
+  if (it == _debitos_reservados.end()) {
+    return;
+  }
+
+  it->second.monto -= monto;
+  if (--it->second.cantidad == 0) {
+    _debitos_reservados.erase(it);
+  }
+}
+
+template <class Politica>
+timestamp BlockchainGenerica<Politica>::confirmar_debito(id_billetera origen, id_billetera destino, double monto, timestamp t) {
+  cancelar_debito(origen, monto);
+  return registrar({origen, destino, monto, t, 0}, _billeteras.at(origen));
+}
+
+template <class Politica>
+bool BlockchainGenerica<Politica>::preparar_credito(id_billetera destino) {
+  if (_billeteras.find(destino) == _billeteras.end()) {
+    return false;
+  }
+
+  _creditos_preparados[destino]++;
+  return true;
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::cancelar_credito(id_billetera destino) {
+  auto it = _creditos_preparados.find(destino);
+  if (it != _creditos_preparados.end() && --it->second == 0) {
+    _creditos_preparados.erase(it);
+  }
+}
+
+template <class Politica>
+timestamp BlockchainGenerica<Politica>::confirmar_credito(id_billetera origen, id_billetera destino, double monto, timestamp t) {
+  cancelar_credito(destino);
+  return registrar({origen, destino, monto, t, 0}, _billeteras.at(destino));
+}
+
+template <class Politica>
+bool BlockchainGenerica<Politica>::cerrar_billetera(BilleteraGenerica<Politica>* billetera, id_billetera destino_saldo) {
+  auto it = _billeteras.find(billetera->id());
+  if (it == _billeteras.end() || it->second != billetera) {
+    return false;
+  }
+
+  bool transferencia_pendiente = _debitos_reservados.count(billetera->id()) > 0 || _creditos_preparados.count(billetera->id()) > 0;
+  if (transferencia_pendiente) {
+    return false;
+  }
+
+  if (billetera->saldo() > 0) {
+    if (destino_saldo == 0 || !agregar_transaccion(billetera, destino_saldo, billetera->saldo())) {
+      return false;
+    }
+  }
+
+  _billeteras.erase(it);
+
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    _billeteras_contiguas[billetera->posicion_contigua()].billetera = nullptr;
+    _billeteras_contiguas_cerradas++;
+    if (_billeteras_contiguas_cerradas * 2 > _billeteras_contiguas.size()) {
+      _billeteras_contiguas.erase(
+        remove_if(_billeteras_contiguas.begin(), _billeteras_contiguas.end(), [](const BilleteraContigua& b) { return b.billetera == nullptr; }),
+        _billeteras_contiguas.end());
+      for (size_t i = 0; i < _billeteras_contiguas.size(); i++) {
+        _billeteras_contiguas[i].billetera->fijar_posicion_contigua(i);
+      }
+      _billeteras_contiguas_cerradas = 0;
+    }
+  }
+  auto bloque = buscar_bloque(billetera->id());
+  if (bloque == _bloques_de_billeteras.end()) {
+    delete billetera;
+  } else if (--bloque->abiertas == 0) {
+    // Era la última abierta del bloque: libero todas sus billeteras juntas.
+    _bloques_de_billeteras.erase(bloque);
+  } else {
+    billetera->liberar_estado();
+  }
 
   return true;
 }
 
-const list<Transaccion>& Blockchain::transacciones() {
+template <class Politica>
+auto BlockchainGenerica<Politica>::buscar_contigua(id_billetera id) const -> typename vector<BilleteraContigua>::const_iterator requires Politica::SALDOS_DIARIOS {
+  return lower_bound(_billeteras_contiguas.begin(), _billeteras_contiguas.end(), id,
+    [](const BilleteraContigua& b, id_billetera id) { return b.id < id; });
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::actualizar_contigua(BilleteraGenerica<Politica>* billetera, int dia) {
+  if constexpr (Politica::SALDOS_DIARIOS) {
+    BilleteraContigua& contigua = _billeteras_contiguas[billetera->posicion_contigua()];
+    contigua.saldo = billetera->saldo();
+    contigua.ultimo_dia = dia;
+  }
+}
+
+template <class Politica>
+monto BlockchainGenerica<Politica>::saldo_contiguo(const BilleteraContigua& contigua, int dia) requires Politica::SALDOS_DIARIOS {
+  // Sin transacciones desde `dia`, el saldo de ese día es el actual.
+  return dia >= contigua.ultimo_dia ? contigua.saldo : contigua.billetera->saldo_al_fin_del_dia_indice(dia);
+}
+
+template <class Politica>
+auto BlockchainGenerica<Politica>::buscar_bloque(id_billetera id) -> typename vector<BloqueDeBilleteras>::iterator {
+  // Los bloques están en orden de id: sólo puede estar en el último que
+  // empieza antes o en `id`.
+  auto siguiente = upper_bound(_bloques_de_billeteras.begin(), _bloques_de_billeteras.end(), id,
+    [](id_billetera id, const BloqueDeBilleteras& bloque) { return id < bloque.billeteras.front().id(); });
+  if (siguiente == _bloques_de_billeteras.begin() || prev(siguiente)->billeteras.back().id() < id) {
+    return _bloques_de_billeteras.end();
+  }
+  return prev(siguiente);
+}
+
+template <class Politica>
+const list<Transaccion>& BlockchainGenerica<Politica>::transacciones() {
   return _transacciones;
 }
 
-monto Blockchain::calcular_saldo(const Billetera* billetera) const {
+template <class Politica>
+id_transaccion BlockchainGenerica<Politica>::ultima_secuencia() const {
+  return _ultima_secuencia;
+}
+
+template <class Politica>
+timestamp BlockchainGenerica<Politica>::ultimo_timestamp() const {
+  return _transacciones.empty() ? 0 : _transacciones.back()._timestamp;
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::transacciones_desde(id_transaccion desde, unsigned int maximo, vector<Transaccion>& lote) const {
+  if (desde >= _ultima_secuencia) {
+    return;
+  }
+
+  // Las secuencias son consecutivas, así que la primera posterior a `desde`
+  // está a (_ultima_secuencia - desde) posiciones del final.
+  auto it = _transacciones.end();
+  for (id_transaccion s = desde; s < _ultima_secuencia; s++) {
+    --it;
+  }
+
+  for (unsigned int i = 0; i < maximo && it != _transacciones.end(); i++, ++it) {
+    lote.push_back(*it);
+  }
+}
+
+template <class Politica>
+Suscripcion* BlockchainGenerica<Politica>::suscribir(id_transaccion desde, unsigned int capacidad) {
+  desde = min(desde, _ultima_secuencia);
+  Suscripcion suscripcion = {desde, capacidad, _transacciones.end()};
+
+  if (desde != 0) {
+    for (id_transaccion s = desde; s <= _ultima_secuencia; s++) {
+      --suscripcion.posicion;
+    }
+  }
+
+  if (capacidad != 0) {
+    _limites_de_suscripciones.insert(static_cast<uint64_t>(desde) + capacidad);
+  }
+
+  _suscripciones.push_back(suscripcion);
+  return &_suscripciones.back();
+}
+
+template <class Politica>
+unsigned int BlockchainGenerica<Politica>::leer(Suscripcion* suscripcion, unsigned int maximo, vector<Transaccion>& lote) {
+  uint64_t limite_anterior = static_cast<uint64_t>(suscripcion->ultima_leida) + suscripcion->capacidad;
+  unsigned int leidas = 0;
+  while (leidas < maximo && suscripcion->ultima_leida < _ultima_secuencia) {
+    // Si todavía no leyó ninguna, la siguiente es la primera del registro.
+    if (suscripcion->ultima_leida == 0) {
+      suscripcion->posicion = _transacciones.begin();
+    } else {
+      ++suscripcion->posicion;
+    }
+
+    lote.push_back(*suscripcion->posicion);
+    suscripcion->ultima_leida = suscripcion->posicion->secuencia;
+    leidas++;
+  }
+
+  if (suscripcion->capacidad != 0 && leidas > 0) {
+    _limites_de_suscripciones.erase(_limites_de_suscripciones.find(limite_anterior));
+    _limites_de_suscripciones.insert(static_cast<uint64_t>(suscripcion->ultima_leida) + suscripcion->capacidad);
+  }
+  return leidas;
+}
+
+template <class Politica>
+unsigned int BlockchainGenerica<Politica>::pendientes(const Suscripcion* suscripcion) const {
+  return _ultima_secuencia - suscripcion->ultima_leida;
+}
+
+template <class Politica>
+bool BlockchainGenerica<Politica>::hay_contrapresion() const {
+  return !_limites_de_suscripciones.empty() && _ultima_secuencia >= *_limites_de_suscripciones.begin();
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::cancelar_suscripcion(Suscripcion* suscripcion) {
+  for (auto it = _suscripciones.begin(); it != _suscripciones.end(); ++it) {
+    if (&*it == suscripcion) {
+      if (it->capacidad != 0) {
+        _limites_de_suscripciones.erase(_limites_de_suscripciones.find(static_cast<uint64_t>(it->ultima_leida) + it->capacidad));
+      }
+      _suscripciones.erase(it);
+      return;
+    }
+  }
+}
+
+template <class Politica>
+monto BlockchainGenerica<Politica>::calcular_saldo(const BilleteraGenerica<Politica>* billetera) const {
   monto resultado = 0;
 
   for (auto it = _transacciones.begin(); it != _transacciones.end(); ++it) {
@@ -70,10 +448,92 @@ monto Blockchain::calcular_saldo(const Billetera* billetera) const {
   return resultado;
 }
 
-Blockchain::~Blockchain() {
+template <class Politica>
+void BlockchainGenerica<Politica>::archivar_historial(timestamp antiguedad) {
+  timestamp ahora = _reloj->ahora();
+  if (ahora < antiguedad) {
+    return;
+  }
+
+  timestamp limite = ahora - antiguedad;
+  for (auto it = _billeteras.begin(); it != _billeteras.end(); ++it) {
+    it->second->archivar(limite);
+  }
+}
+
+template <class Politica>
+EstadisticasMemoria BlockchainGenerica<Politica>::estadisticas_memoria() const {
+  EstadisticasMemoria total;
+  for (auto it = _billeteras.begin(); it != _billeteras.end(); ++it) {
+    total += it->second->estadisticas_memoria();
+  }
+  return total;
+}
+
+template <class Politica>
+size_t BlockchainGenerica<Politica>::cantidad_billeteras() const {
+  return _billeteras.size();
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::saldos_al_fin_del_dia(timestamp t, monto* saldos, id_billetera* ids, unsigned int hilos) const requires Politica::SALDOS_DIARIOS {
+  // Posición de salida de cada billetera: si no hay cerradas es la misma que
+  // en la copia contigua; si no, la compacto primero en una lista de índices.
+  vector<size_t> abiertas;
+  if (_billeteras_contiguas_cerradas > 0) {
+    abiertas.reserve(_billeteras.size());
+    for (size_t i = 0; i < _billeteras_contiguas.size(); i++) {
+      if (_billeteras_contiguas[i].billetera != nullptr) {
+        abiertas.push_back(i);
+      }
+    }
+  }
+
+  // El día es el mismo para todas las billeteras, lo calculo una sola vez.
+  int dia = static_cast<int>(t / DiaEnCurso::DURACION_DIA);
+  en_paralelo(_billeteras.size(), hilos, [&](size_t desde, size_t hasta) {
+    for (size_t i = desde; i < hasta; i++) {
+      const BilleteraContigua& contigua = _billeteras_contiguas[abiertas.empty() ? i : abiertas[i]];
+      saldos[i] = saldo_contiguo(contigua, dia);
+      if (ids != nullptr) {
+        ids[i] = contigua.id;
+      }
+    }
+  });
+}
+
+template <class Politica>
+void BlockchainGenerica<Politica>::saldos_al_fin_del_dia(timestamp t, const vector<id_billetera>& ids, monto* saldos, unsigned int hilos) const requires Politica::SALDOS_DIARIOS {
+  int dia = static_cast<int>(t / DiaEnCurso::DURACION_DIA);
+  en_paralelo(ids.size(), hilos, [&](size_t desde, size_t hasta) {
+    for (size_t i = desde; i < hasta; i++) {
+      auto contigua = buscar_contigua(ids[i]);
+      bool registrada = contigua != _billeteras_contiguas.end() && contigua->id == ids[i] && contigua->billetera != nullptr;
+      saldos[i] = registrada ? saldo_contiguo(*contigua, dia) : 0;
+    }
+  });
+}
+
+template <class Politica>
+BlockchainGenerica<Politica>::~BlockchainGenerica() {
+  // Las billeteras de `_bloques_de_billeteras` se liberan con su bloque. Como
+  // tanto el registro como los bloques están ordenados por id, los recorro a
+  // la par para saltearlas.
+  auto bloque = this->_bloques_de_billeteras.begin();
   auto it = this->_billeteras.begin();
   while (it != this->_billeteras.end()) {
-    delete it->second;
+    while (bloque != this->_bloques_de_billeteras.end() && bloque->billeteras.back().id() < it->first) {
+      ++bloque;
+    }
+
+    bool en_bloque = bloque != this->_bloques_de_billeteras.end() && bloque->billeteras.front().id() <= it->first;
+    if (!en_bloque) {
+      delete it->second;
+    }
     ++it;
   }
 }
+
+// Instanciaciones explícitas de las políticas provistas en politicas.h.
+template class BlockchainGenerica<PoliticaCompleta>;
+template class BlockchainGenerica<PoliticaSoloSaldo>;
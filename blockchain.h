@@ -1,20 +1,71 @@
 #ifndef BLOCKCHAIN_H
 #define BLOCKCHAIN_H
 
+#include <cstdint>
 #include <list>
 #include <map>
+#include <set>
+#include <vector>
 #include <cstdlib>
 
 #include "lib.h"
+#include "politicas.h"
+#include "historial_frio.h"
+#include "reloj.h"
 
 using namespace std;
 
-class Billetera;
+template <class Politica>
+class BilleteraGenerica;
 
-class Blockchain {
+/**
+ * Cursor de un consumidor del feed de transacciones (ver
+ * `BlockchainGenerica::suscribir`). Lo crea y lo libera la blockchain.
+ */
+struct Suscripcion {
+  /** Secuencia de la última transacción entregada al consumidor (0 si ninguna). */
+  id_transaccion ultima_leida;
+
+  /**
+   * Máxima cantidad de transacciones pendientes de leer. Mientras se alcance,
+   * la blockchain rechaza transacciones nuevas de `agregar_transaccion`. 0 si
+   * no hay límite. Es un límite aproximado: las transacciones semilla y las
+   * confirmaciones en dos fases se registran igual y pueden superarlo.
+   */
+  unsigned int capacidad;
+
+  /** Posición de `ultima_leida` en el registro, si `ultima_leida` no es 0. */
+  list<Transaccion>::const_iterator posicion;
+};
+
+/**
+ * Blockchain parametrizada por una política de compilación (ver politicas.h)
+ * que decide qué estructuras derivadas mantienen sus billeteras.
+ */
+template <class Politica>
+class BlockchainGenerica {
   public:
-    /** Constructor */
-    Blockchain();
+    /** Constructor. Toma el tiempo de `RelojCalendario::global()`. */
+    BlockchainGenerica();
+
+    /**
+     * Constructor que toma el tiempo de `reloj`, que debe vivir más que la
+     * blockchain. Blockchains con relojes propios (por ejemplo `RelojManual`)
+     * no comparten estado y pueden usarse en hilos distintos.
+     */
+    explicit BlockchainGenerica(Reloj* reloj);
+
+    /**
+     * Constructor que fija los ids de las billeteras: la primera tendrá id
+     * `primer_id` y cada una siguiente `paso` más que la anterior. Permite que
+     * varias blockchains repartan el espacio de ids sin superponerse (ver
+     * shards.h).
+     *
+     * Si `reloj` es `nullptr` se usa `RelojCalendario::global()`.
+     *
+     * Se asume como precondición que `primer_id` y `paso` son mayores a 0.
+     */
+    BlockchainGenerica(id_billetera primer_id, id_billetera paso, Reloj* reloj = nullptr);
 
     /**
      * Registra una billetera en la blockchain y devuelve un puntero a la misma.
@@ -23,7 +74,20 @@ class Blockchain {
      *
      * Complejidad: misma que agregar_transacción.
      */
-    Billetera* abrir_billetera();
+    BilleteraGenerica<Politica>* abrir_billetera();
+
+    /**
+     * Registra `n` billeteras con ids consecutivos (según el paso de ids) y devuelve punteros a las
+     * mismas, en orden de id. Es equivalente a llamar `n` veces a
+     * `abrir_billetera` en el mismo instante, pero:
+     *   - las billeteras se reservan juntas en un único bloque de memoria
+     *   - las transacciones semilla se agregan al registro de una sola vez
+     *   - el estado inicial de cada billetera se carga con `registrar_semilla`
+     *   - los ids se insertan al final del registro, sin buscar la posición
+     *
+     * Complejidad: O(n)
+     */
+    vector<BilleteraGenerica<Politica>*> abrir_billeteras(unsigned int n);
 
     /**
      * Agrega una transacción.
@@ -33,12 +97,123 @@ class Blockchain {
      *   - el puntero de la billetera origen coincida con el que hay en registro
      *   - la billetera origen tenga monto suficiente
      *   - sean billeteras distintas
+     *   - la billetera origen tenga monto suficiente sin contar lo reservado
+     *     por `reservar_debito`
+     *   - ninguna suscripción con capacidad tenga su capacidad de pendientes
+     *     completa
+     *
+     * Devuelve `true` si y sólo si la transacción se registró con éxito. Si
+     * devuelve `false` y `hay_contrapresion()` es `true`, la transacción puede
+     * ser válida y conviene reintentarla cuando los consumidores lean.
+     *
+     * El saldo del origen se toma de la billetera, que lo mantiene actualizado
+     * en cada notificación, en vez de recorrer todas las transacciones.
+     *
+     * Complejidad: O(log(B) + log(R) + NT), donde R es la cantidad de
+     * billeteras con débitos reservados y NT es la complejidad del método
+     * notificar_transaccion de la clase Billetera
+     */
+    bool agregar_transaccion(BilleteraGenerica<Politica>* origen, id_billetera destino, double monto);
+
+    /**
+     * Devuelve la billetera registrada con id `id`, o `nullptr` si no hay
+     * ninguna.
+     *
+     * Complejidad: O(log(B))
+     */
+    BilleteraGenerica<Politica>* billetera(id_billetera id) const;
+
+    //--------------------------------------------------------------------------
+    // Transferencias hacia billeteras de otra blockchain, en dos fases. La
+    // blockchain del origen reserva el monto (`reservar_debito`) y la del
+    // destino impide que la billetera se cierre (`preparar_credito`); si ambas
+    // aceptan se confirman las dos, y si no se cancela la que haya aceptado.
+    // Cada blockchain registra la transacción en su propio registro y sólo
+    // notifica a su billetera. Las confirmaciones no se frenan por las
+    // suscripciones con capacidad.
+    //
+    // Entre la preparación y la confirmación la blockchain puede registrar
+    // otras transacciones, así que la confirmación nunca usa un timestamp
+    // anterior al de la última transacción registrada (ver `ultimo_timestamp`).
+    // Así el registro y el historial de cada billetera siguen en orden
+    // cronológico.
+    //--------------------------------------------------------------------------
+
+    /**
+     * Fase 1 del lado del origen. Valida que `origen` esté registrada y tenga
+     * monto suficiente sin contar lo ya reservado, y reserva `monto`.
+     *
+     * Complejidad: O(log(B) + log(R))
+     */
+    bool reservar_debito(BilleteraGenerica<Politica>* origen, double monto);
+
+    /**
+     * Libera una reserva hecha con `reservar_debito`.
+     *
+     * Complejidad: O(log(R))
+     */
+    void cancelar_debito(id_billetera origen, double monto);
+
+    /**
+     * Fase 2 del lado del origen. Libera la reserva y registra la transacción
+     * de `origen` a `destino`, que pertenece a otra blockchain, con timestamp
+     * `t` o el de la última transacción registrada si es posterior. Devuelve
+     * el timestamp registrado.
+     *
+     * Complejidad: O(log(B) + log(R) + NT)
+     */
+    timestamp confirmar_debito(id_billetera origen, id_billetera destino, double monto, timestamp t);
+
+    /**
+     * Fase 1 del lado del destino. Valida que `destino` esté registrada e
+     * impide que se cierre hasta confirmar o cancelar.
+     *
+     * Complejidad: O(log(B) + log(R))
+     */
+    bool preparar_credito(id_billetera destino);
+
+    /**
+     * Deshace un `preparar_credito`.
      *
-     * Devuelve `true` si y sólo si la transacción se registró con éxito.
+     * Complejidad: O(log(R))
+     */
+    void cancelar_credito(id_billetera destino);
+
+    /**
+     * Fase 2 del lado del destino. Registra la transacción de `origen`, que
+     * pertenece a otra blockchain, a `destino`, con timestamp `t` o el de la
+     * última transacción registrada si es posterior. Devuelve el timestamp
+     * registrado.
      *
-     * Complejidad: O(log(B) + T + NT), donde NT es la complejidad del método notificar_transaccion de la clase Billetera
+     * Complejidad: O(log(B) + log(R) + NT)
      */
-    bool agregar_transaccion(Billetera* origen, id_billetera destino, double monto);
+    timestamp confirmar_credito(id_billetera origen, id_billetera destino, double monto, timestamp t);
+
+    /**
+     * Cierra la billetera `billetera`. Si tiene saldo, primero lo transfiere a
+     * `destino_saldo` con `agregar_transaccion`; si no hay destino (0) o la
+     * transferencia se rechaza, la billetera no se cierra. Como en
+     * `agregar_transaccion`, `hay_contrapresion()` indica si el rechazo se
+     * debió a una suscripción llena.
+     *
+     * Tampoco se cierra si tiene una transferencia en dos fases pendiente.
+     *
+     * Al cerrarla se quita del registro, por lo que las transferencias hacia
+     * o desde ella se rechazan como las de cualquier id desconocido, y se
+     * libera la memoria de su estado derivado. Las transacciones en las que
+     * participó quedan en el registro. El puntero `billetera` deja de ser
+     * válido.
+     *
+     * Si la billetera se abrió con `abrir_billeteras`, el objeto vive en su
+     * bloque y se libera recién cuando se cierran todas las billeteras del
+     * bloque; mientras tanto sólo ocupa `sizeof(BilleteraGenerica)`.
+     *
+     * Devuelve `true` si y sólo si la billetera se cerró.
+     *
+     * Complejidad: O(log(B) + log(K) + NT + H + D + C), donde K es la cantidad
+     * de bloques de `abrir_billeteras`
+     */
+    bool cerrar_billetera(BilleteraGenerica<Politica>* billetera, id_billetera destino_saldo);
 
     /**
      * Lista de todas las transacciones registradas.
@@ -47,21 +222,216 @@ class Blockchain {
      */
     const list<Transaccion>& transacciones();
 
+    /**
+     * Secuencia de la última transacción registrada (0 si no hay ninguna).
+     *
+     * Complejidad: O(1)
+     */
+    id_transaccion ultima_secuencia() const;
+
+    /**
+     * Timestamp de la última transacción registrada (0 si no hay ninguna).
+     *
+     * Complejidad: O(1)
+     */
+    timestamp ultimo_timestamp() const;
+
+    /**
+     * Agrega a `lote` hasta `maximo` transacciones con secuencia mayor a
+     * `desde`, en orden de secuencia.
+     *
+     * Complejidad: O(N), donde N es la cantidad de transacciones posteriores a `desde`
+     */
+    void transacciones_desde(id_transaccion desde, unsigned int maximo, vector<Transaccion>& lote) const;
+
+    /**
+     * Crea un cursor que entrega las transacciones con secuencia mayor a
+     * `desde`. Si `capacidad` no es 0, mientras el consumidor tenga
+     * `capacidad` transacciones pendientes de leer se rechazan transacciones
+     * nuevas, de modo que un consumidor lento frena a la blockchain en vez de
+     * quedar arbitrariamente atrasado. El límite es aproximado: las
+     * transacciones semilla y las confirmaciones en dos fases no se frenan, así
+     * que los pendientes pueden superar `capacidad`.
+     *
+     * Complejidad: O(N + log(S)), donde N es la cantidad de transacciones
+     * posteriores a `desde` y S la cantidad de suscripciones
+     */
+    Suscripcion* suscribir(id_transaccion desde, unsigned int capacidad);
+
+    /**
+     * Agrega a `lote` hasta `maximo` transacciones pendientes de la suscripción
+     * y las marca como leídas. Devuelve la cantidad agregada.
+     *
+     * Complejidad: O(L + log(S)), donde L es la cantidad de transacciones agregadas
+     */
+    unsigned int leer(Suscripcion* suscripcion, unsigned int maximo, vector<Transaccion>& lote);
+
+    /**
+     * Cantidad de transacciones pendientes de leer de la suscripción.
+     *
+     * Complejidad: O(1)
+     */
+    unsigned int pendientes(const Suscripcion* suscripcion) const;
+
+    /**
+     * Indica si alguna suscripción con capacidad la tiene completa, en cuyo
+     * caso `agregar_transaccion` rechaza toda transacción.
+     *
+     * Complejidad: O(1)
+     */
+    bool hay_contrapresion() const;
+
+    /**
+     * Elimina la suscripción. El puntero deja de ser válido.
+     *
+     * Complejidad: O(S)
+     */
+    void cancelar_suscripcion(Suscripcion* suscripcion);
+
     /**
      * Calcula el saldo actual de una billetera, recorriendo toda la lista de
      * transacciones.
      *
      * Complejidad: O(T)
      */
-    monto calcular_saldo(const Billetera* billetera) const;
+    monto calcular_saldo(const BilleteraGenerica<Politica>* billetera) const;
+
+    /**
+     * Archiva en el nivel frío de cada billetera el historial con más de
+     * `antiguedad` segundos respecto del tiempo actual (ver
+     * `Billetera::archivar`).
+     *
+     * Complejidad: O(B * (H + D))
+     */
+    void archivar_historial(timestamp antiguedad);
+
+    /**
+     * Suma la memoria usada por el historial de todas las billeteras, por
+     * nivel, y la de sus rankings.
+     *
+     * Complejidad: O(B + P), donde P es la cantidad total de checkpoints del
+     * ranking
+     */
+    EstadisticasMemoria estadisticas_memoria() const;
+
+    /**
+     * Cantidad de billeteras abiertas y no cerradas.
+     *
+     * Complejidad: O(1)
+     */
+    size_t cantidad_billeteras() const;
+
+    /**
+     * Escribe en `saldos` el saldo al fin del día de `t` de todas las
+     * billeteras registradas, en orden creciente de id, y si `ids` no es nulo
+     * escribe sus ids en la misma posición. Ambos buffers los provee quien
+     * llama y deben tener lugar para `cantidad_billeteras()` elementos.
+     *
+     * Recorre la copia contigua del registro repartiéndola en `hilos` hilos
+     * (0 usa los que tenga el equipo). Las billeteras abiertas después del día
+     * de `t` tienen saldo 0.
+     *
+     * La copia contigua guarda, junto a cada billetera, su saldo actual y el
+     * día de su última transacción. Si `t` no es anterior a ese día el saldo
+     * sale de la copia sin leer la billetera; si no, se busca en sus saldos
+     * diarios. Consultar por un día reciente sólo lee las billeteras que
+     * operaron después.
+     *
+     * Cada llamada con más de un hilo los crea y los espera, lo que cuesta
+     * decenas de microsegundos por hilo. Sólo se reparte en varios con al
+     * menos 4096 billeteras por hilo, donde ese costo es chico frente al
+     * recorrido.
+     *
+     * Complejidad: O(B*log(D) / hilos), y O(B / hilos) si ninguna billetera
+     * operó después del día de `t`
+     *
+     * Requiere que la política habilite SALDOS_DIARIOS.
+     */
+    void saldos_al_fin_del_dia(timestamp t, monto* saldos, id_billetera* ids = nullptr, unsigned int hilos = 0) const requires Politica::SALDOS_DIARIOS;
+
+    /**
+     * Igual que la anterior, pero sólo para las billeteras de `ids`: escribe
+     * en `saldos[i]` el saldo al fin del día de `t` de `ids[i]`, o 0 si no
+     * está registrada.
+     *
+     * Complejidad: O(N*(log(B) + log(D)) / hilos), donde N es el tamaño de `ids`
+     *
+     * Requiere que la política habilite SALDOS_DIARIOS.
+     */
+    void saldos_al_fin_del_dia(timestamp t, const vector<id_billetera>& ids, monto* saldos, unsigned int hilos = 0) const requires Politica::SALDOS_DIARIOS;
 
     /**
      * Destructor.
      * Libera la memoria dinámica pedida por la blockchain al crear billeteras.
      */
-    ~Blockchain();
+    ~BlockchainGenerica();
 
   private:
+    /**
+     * Billeteras abiertas juntas con `abrir_billeteras`. Mover el bloque no
+     * mueve sus billeteras, así que los punteros a ellas siguen siendo
+     * válidos al crecer `_bloques_de_billeteras`.
+     */
+    struct BloqueDeBilleteras {
+      vector<BilleteraGenerica<Politica>> billeteras;
+
+      /** Cantidad de billeteras del bloque que no se cerraron. */
+      size_t abiertas;
+    };
+
+    /**
+     * Bloque de `abrir_billeteras` al que pertenece la billetera `id`, o
+     * `_bloques_de_billeteras.end()` si no pertenece a ninguno, en cuyo caso
+     * la billetera se libera individualmente.
+     *
+     * Complejidad: O(log(K)), donde K es la cantidad de bloques
+     */
+    typename vector<BloqueDeBilleteras>::iterator buscar_bloque(id_billetera id);
+
+    /**
+     * Entrada de `_billeteras_contiguas`. Para cualquier día desde
+     * `ultimo_dia` el saldo al fin del día es `saldo`, así que los recorridos
+     * de `saldos_al_fin_del_dia` sólo leen la billetera para días anteriores.
+     */
+    struct BilleteraContigua {
+      id_billetera id;
+
+      /** Saldo actual de la billetera. */
+      monto saldo;
+
+      /** Índice del día de la última transacción de la billetera. */
+      int ultimo_dia;
+
+      /** La billetera, o nulo si se cerró. */
+      BilleteraGenerica<Politica>* billetera;
+    };
+
+    /**
+     * Posición de la billetera `id` en `_billeteras_contiguas`, o de la
+     * primera con id mayor si no está.
+     *
+     * Complejidad: O(log(B))
+     */
+    typename vector<BilleteraContigua>::const_iterator buscar_contigua(id_billetera id) const requires Politica::SALDOS_DIARIOS;
+
+    /**
+     * Actualiza el saldo y el último día de `billetera` en
+     * `_billeteras_contiguas` después de notificarla de una transacción del
+     * día `dia`. No hace nada si la política no habilita SALDOS_DIARIOS.
+     *
+     * Complejidad: O(1)
+     */
+    void actualizar_contigua(BilleteraGenerica<Politica>* billetera, int dia);
+
+    /**
+     * Saldo al fin del día `dia` de la billetera de `contigua`. Sólo lee la
+     * billetera si tuvo transacciones después de ese día.
+     *
+     * Complejidad: O(1) si `dia` no es anterior a `contigua.ultimo_dia`, y
+     * O(log(D)) si no
+     */
+    static monto saldo_contiguo(const BilleteraContigua& contigua, int dia) requires Politica::SALDOS_DIARIOS;
+
     /** Listado de todas las transacciones realizadas */
     list<Transaccion> _transacciones;
 
@@ -69,13 +439,85 @@ class Blockchain {
      * Registro de todas las billeteras que fueron abiertas. Se mantiene un
      * puntero a cada una para poder notificarlas cuando hay una transacción.
      */
-    map<id_billetera, Billetera *> _billeteras;
+    map<id_billetera, BilleteraGenerica<Politica> *> _billeteras;
+
+    /**
+     * Copia contigua de `_billeteras`, ordenada por id, para los recorridos de
+     * `saldos_al_fin_del_dia`. Las billeteras cerradas quedan con puntero nulo
+     * hasta que son más de la mitad y se compacta; cada billetera sabe su
+     * posición (ver `BilleteraGenerica::posicion_contigua`). Sólo se mantiene
+     * si la política habilita SALDOS_DIARIOS.
+     */
+    [[no_unique_address]] Opcional<Politica::SALDOS_DIARIOS, vector<BilleteraContigua>> _billeteras_contiguas;
+
+    /** Cantidad de punteros nulos en `_billeteras_contiguas`. */
+    [[no_unique_address]] Opcional<Politica::SALDOS_DIARIOS, size_t> _billeteras_contiguas_cerradas;
+
+    /**
+     * Bloques de billeteras abiertas con `abrir_billeteras`, en orden creciente
+     * de id. Cada bloque es dueño de sus billeteras, que no deben liberarse
+     * individualmente; el bloque se libera al cerrarse todas.
+     */
+    vector<BloqueDeBilleteras> _bloques_de_billeteras;
+
+    /**
+     * Registra `transaccion`, asignándole la siguiente secuencia, y notifica
+     * a `billetera`. Si su timestamp es anterior al de la última transacción
+     * registrada, usa el de ésta. Devuelve el timestamp registrado.
+     */
+    timestamp registrar(Transaccion transaccion, BilleteraGenerica<Politica>* billetera);
+
+    /**
+     * Reservas abiertas de una billetera. La cantidad decide cuándo no queda
+     * ninguna, porque el monto es una suma de doubles y al restar puede no
+     * volver exactamente a 0.
+     */
+    struct DebitoReservado {
+      double monto;
+      unsigned int cantidad;
+    };
+
+    /** Reservas de transferencias en dos fases, por billetera origen. */
+    map<id_billetera, DebitoReservado> _debitos_reservados;
+
+    /** Créditos preparados y no confirmados, por billetera destino. */
+    map<id_billetera, unsigned int> _creditos_preparados;
+
+    /** Fuente del tiempo de las transacciones. No es de la blockchain. */
+    Reloj* _reloj;
+
+    /**
+     * Límites del día de la última transacción registrada, para pasarle a
+     * las billeteras el índice del día sin dividir en cada transacción.
+     */
+    DiaEnCurso _dia_en_curso;
+
+    /** Suscripciones activas al feed de transacciones. */
+    list<Suscripcion> _suscripciones;
+
+    /**
+     * `ultima_leida + capacidad` de cada suscripción con capacidad: hay
+     * contrapresión si y sólo si la última secuencia alcanza el menor.
+     */
+    multiset<uint64_t> _limites_de_suscripciones;
+
+    /** Secuencia de la última transacción registrada. */
+    id_transaccion _ultima_secuencia;
 
     /** Lleva cuenta del siguiente id a utilizar. */
     id_billetera _siguiente_id_billetera;
 
+    /** Diferencia entre los ids de dos billeteras abiertas consecutivamente. */
+    id_billetera _paso_id_billetera;
+
     /** El saldo inicial de todas las billeteras al momento de registrarse. */
     static const monto SALDO_INICIAL = 100;
 };
 
+/** Blockchain con todas las estructuras habilitadas. */
+using Blockchain = BlockchainGenerica<PoliticaCompleta>;
+
+/** Blockchain cuyas billeteras sólo mantienen su saldo. */
+using BlockchainSoloSaldo = BlockchainGenerica<PoliticaSoloSaldo>;
+
 #endif
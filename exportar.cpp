@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "exportar.h"
+
+using namespace std;
+
+namespace {
+
+const char MAGIA[8] = {'T', 'D', '3', 'L', 'E', 'D', 'G', 'R'};
+const uint32_t VERSION = 1;
+const uint32_t BYTES_POR_REGISTRO = 24;
+
+const char ENCABEZADO_CSV[] = "secuencia,timestamp,origen,destino,monto\n";
+
+void escribir_u32(char* destino, uint32_t valor) {
+  for (int i = 0; i < 4; i++) {
+    destino[i] = static_cast<char>(valor >> (8 * i));
+  }
+}
+
+void escribir_u64(char* destino, uint64_t valor) {
+  for (int i = 0; i < 8; i++) {
+    destino[i] = static_cast<char>(valor >> (8 * i));
+  }
+}
+
+} // namespace
+
+ExportadorLedger::ExportadorLedger(const list<Transaccion>& transacciones, int fd, Formato formato,
+                                   id_transaccion desde_secuencia, id_transaccion hasta_secuencia,
+                                   timestamp desde_timestamp, timestamp hasta_timestamp)
+  : _transacciones(transacciones)
+  , _fd(fd)
+  , _formato(formato)
+  , _desde_timestamp(desde_timestamp)
+  , _hasta_timestamp(hasta_timestamp)
+  , _posicion(transacciones.end())
+  , _encabezado_escrito(false)
+  , _error(false)
+  , _exportadas(0)
+  , _en_uso(0)
+{
+  id_transaccion registrada = transacciones.empty() ? 0 : transacciones.back().secuencia;
+  _ultima = min(hasta_secuencia, registrada);
+  _recorrida = min(desde_secuencia, _ultima);
+
+  // Las secuencias son consecutivas, así que la de `_recorrida` está a
+  // (registrada - _recorrida) posiciones de la última.
+  if (_recorrida != 0) {
+    for (id_transaccion s = _recorrida; s <= registrada; s++) {
+      --_posicion;
+    }
+  }
+}
+
+bool ExportadorLedger::avanzar(size_t maximo) {
+  if (!_encabezado_escrito) {
+    if (_formato == BINARIO) {
+      char* encabezado = reservar(16);
+      memcpy(encabezado, MAGIA, sizeof(MAGIA));
+      escribir_u32(encabezado + 8, VERSION);
+      escribir_u32(encabezado + 12, BYTES_POR_REGISTRO);
+    } else {
+      memcpy(reservar(sizeof(ENCABEZADO_CSV) - 1), ENCABEZADO_CSV, sizeof(ENCABEZADO_CSV) - 1);
+    }
+    _encabezado_escrito = true;
+  }
+
+  for (size_t i = 0; i < maximo && _recorrida < _ultima && !_error; i++) {
+    // Si todavía no se recorrió ninguna, la siguiente es la primera del registro.
+    if (_recorrida == 0) {
+      _posicion = _transacciones.begin();
+    } else {
+      ++_posicion;
+    }
+    _recorrida = _posicion->secuencia;
+
+    // Los timestamps no decrecen, así que pasado el rango no queda nada más.
+    if (_posicion->_timestamp > _hasta_timestamp) {
+      _recorrida = _ultima;
+    } else if (_posicion->_timestamp >= _desde_timestamp) {
+      serializar(*_posicion);
+      _exportadas++;
+    }
+  }
+
+  escribir();
+  return _recorrida < _ultima && !_error;
+}
+
+void ExportadorLedger::exportar_todo() {
+  while (avanzar(SIZE_MAX)) {}
+}
+
+bool ExportadorLedger::error() const {
+  return _error;
+}
+
+size_t ExportadorLedger::exportadas() const {
+  return _exportadas;
+}
+
+void ExportadorLedger::serializar(const Transaccion& tx) {
+  if (_formato == BINARIO) {
+    char* registro = reservar(BYTES_POR_REGISTRO);
+    uint64_t monto_bits;
+    memcpy(&monto_bits, &tx.monto, sizeof(double));
+
+    escribir_u32(registro, tx.secuencia);
+    escribir_u32(registro + 4, tx._timestamp);
+    escribir_u32(registro + 8, tx.origen);
+    escribir_u32(registro + 12, tx.destino);
+    escribir_u64(registro + 16, monto_bits);
+    return;
+  }
+
+  // to_chars no reserva memoria ni depende del locale; para el monto usa la
+  // representación más corta que se vuelve a leer como el mismo double.
+  char linea[128];
+  char* fin = linea;
+  fin = to_chars(fin, linea + sizeof(linea), tx.secuencia).ptr;
+  *fin++ = ',';
+  fin = to_chars(fin, linea + sizeof(linea), tx._timestamp).ptr;
+  *fin++ = ',';
+  fin = to_chars(fin, linea + sizeof(linea), tx.origen).ptr;
+  *fin++ = ',';
+  fin = to_chars(fin, linea + sizeof(linea), tx.destino).ptr;
+  *fin++ = ',';
+  fin = to_chars(fin, linea + sizeof(linea), tx.monto).ptr;
+  *fin++ = '\n';
+
+  memcpy(reservar(fin - linea), linea, fin - linea);
+}
+
+char* ExportadorLedger::reservar(size_t n) {
+  if (_en_uso == 0 || _buffers[_en_uso - 1].size() + n > BYTES_POR_BUFFER) {
+    if (_en_uso == BUFFERS_POR_ESCRITURA) {
+      escribir();
+    }
+    if (_en_uso == _buffers.size()) {
+      _buffers.emplace_back();
+      _buffers.back().reserve(BYTES_POR_BUFFER);
+    }
+    _en_uso++;
+  }
+
+  vector<char>& buffer = _buffers[_en_uso - 1];
+  buffer.resize(buffer.size() + n);
+  return buffer.data() + buffer.size() - n;
+}
+
+void ExportadorLedger::escribir() {
+  vector<iovec> partes;
+  for (size_t i = 0; i < _en_uso; i++) {
+    if (!_buffers[i].empty()) {
+      partes.push_back({_buffers[i].data(), _buffers[i].size()});
+    }
+  }
+
+  // writev puede escribir menos de lo pedido; reintento con lo que falta.
+  size_t primera = 0;
+  while (!_error && primera < partes.size()) {
+    ssize_t escritos = writev(_fd, partes.data() + primera, static_cast<int>(partes.size() - primera));
+    if (escritos < 0) {
+      _error = errno != EINTR;
+      continue;
+    }
+
+    size_t restantes = static_cast<size_t>(escritos);
+    while (primera < partes.size() && restantes >= partes[primera].iov_len) {
+      restantes -= partes[primera].iov_len;
+      primera++;
+    }
+    if (primera < partes.size()) {
+      partes[primera].iov_base = static_cast<char*>(partes[primera].iov_base) + restantes;
+      partes[primera].iov_len -= restantes;
+    }
+  }
+
+  // Los buffers se reutilizan, clear() conserva la capacidad.
+  for (size_t i = 0; i < _en_uso; i++) {
+    _buffers[i].clear();
+  }
+  _en_uso = 0;
+}
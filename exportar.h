@@ -0,0 +1,116 @@
+#ifndef EXPORTAR_H_
+#define EXPORTAR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+#include "lib.h"
+
+using namespace std;
+
+/**
+ * Exporta el registro de transacciones de una blockchain (o un rango de
+ * secuencias y timestamps del mismo) a un file descriptor.
+ *
+ * Formatos:
+ *   - BINARIO: un encabezado de 16 bytes ("TD3LEDGR", versión y tamaño de
+ *     registro, little endian) seguido de un registro de 24 bytes por
+ *     transacción: secuencia, timestamp, origen y destino como uint32 y el
+ *     monto como double, todo little endian.
+ *   - CSV: un encabezado `secuencia,timestamp,origen,destino,monto` y una línea
+ *     por transacción.
+ *
+ * Las transacciones se serializan en varios buffers contiguos que se escriben
+ * juntos con `writev`.
+ *
+ * El exportador toma al construirse la última secuencia registrada y sólo
+ * exporta hasta ella. Como el registro es una lista a la que sólo se agrega al
+ * final, la blockchain puede seguir registrando transacciones entre llamadas a
+ * `avanzar` sin afectar la exportación. El registro no debe modificarse
+ * mientras se ejecuta `avanzar`.
+ */
+class ExportadorLedger {
+  public:
+    enum Formato { BINARIO, CSV };
+
+    /**
+     * Prepara la exportación de las transacciones de `transacciones` con
+     * secuencia en (`desde_secuencia`, `hasta_secuencia`] y timestamp en
+     * [`desde_timestamp`, `hasta_timestamp`], hacia `fd`. No escribe nada.
+     *
+     * Se asume como precondición que `transacciones` tiene las secuencias
+     * 1, 2, 3, ... en orden, con timestamps no decrecientes.
+     *
+     * Complejidad: O(N), donde N es la cantidad de transacciones posteriores
+     * a `desde_secuencia`
+     */
+    ExportadorLedger(const list<Transaccion>& transacciones, int fd, Formato formato,
+                     id_transaccion desde_secuencia = 0, id_transaccion hasta_secuencia = UINT32_MAX,
+                     timestamp desde_timestamp = 0, timestamp hasta_timestamp = UINT32_MAX);
+
+    /**
+     * Exporta hasta `maximo` transacciones más del rango. Devuelve `true` si
+     * quedan transacciones por exportar.
+     *
+     * Complejidad: O(maximo)
+     */
+    bool avanzar(size_t maximo);
+
+    /**
+     * Exporta todo lo que falta del rango.
+     *
+     * Complejidad: O(N), donde N es la cantidad de transacciones que faltan
+     */
+    void exportar_todo();
+
+    /** Indica si falló alguna escritura. Después de un error no se escribe más. */
+    bool error() const;
+
+    /** Cantidad de transacciones exportadas hasta ahora. */
+    size_t exportadas() const;
+
+    /** Tamaño de cada buffer que se pasa a `writev`. */
+    static const size_t BYTES_POR_BUFFER = 64 * 1024;
+
+    /** Cantidad de buffers por llamada a `writev`. */
+    static const size_t BUFFERS_POR_ESCRITURA = 16;
+
+  private:
+    /** Serializa `tx` al final de los buffers, empezando uno nuevo si no entra. */
+    void serializar(const Transaccion& tx);
+
+    /** Agrega `n` bytes a los buffers, empezando uno nuevo si no entran. */
+    char* reservar(size_t n);
+
+    /** Escribe todos los buffers con `writev` y los vacía. */
+    void escribir();
+
+    const list<Transaccion>& _transacciones;
+    const int _fd;
+    const Formato _formato;
+    const timestamp _desde_timestamp;
+    const timestamp _hasta_timestamp;
+
+    /** Última secuencia a exportar. */
+    id_transaccion _ultima;
+
+    /** Secuencia de la última transacción recorrida (0 si ninguna). */
+    id_transaccion _recorrida;
+
+    /** Posición de `_recorrida` en el registro, si `_recorrida` no es 0. */
+    list<Transaccion>::const_iterator _posicion;
+
+    bool _encabezado_escrito;
+    bool _error;
+    size_t _exportadas;
+
+    /**
+     * Buffers de salida. Los primeros `_en_uso` están pendientes de escribir
+     * y el último de ellos es el que se está llenando.
+     */
+    vector<vector<char>> _buffers;
+    size_t _en_uso;
+};
+
+#endif // EXPORTAR_H_
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstring>
+
+#include "historial_frio.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t MONTO_NO_ENTERO = 1;
+
+void escribir_varint(vector<uint8_t>& datos, uint64_t valor) {
+  while (valor >= 0x80) {
+    datos.push_back(static_cast<uint8_t>(valor) | 0x80);
+    valor >>= 7;
+  }
+  datos.push_back(static_cast<uint8_t>(valor));
+}
+
+uint64_t leer_varint(const vector<uint8_t>& datos, size_t& pos) {
+  uint64_t valor = 0;
+  int desplazamiento = 0;
+  while (datos[pos] & 0x80) {
+    valor |= static_cast<uint64_t>(datos[pos] & 0x7f) << desplazamiento;
+    desplazamiento += 7;
+    pos++;
+  }
+  valor |= static_cast<uint64_t>(datos[pos]) << desplazamiento;
+  pos++;
+  return valor;
+}
+
+// Los montos enteros se guardan como varint(monto << 1). Los que no lo son,
+// como la marca MONTO_NO_ENTERO seguida de los 8 bytes del double.
+void escribir_monto(vector<uint8_t>& datos, double monto) {
+  if (monto >= 0 && monto < (1ull << 52) && monto == static_cast<double>(static_cast<uint64_t>(monto))) {
+    escribir_varint(datos, static_cast<uint64_t>(monto) << 1);
+    return;
+  }
+  escribir_varint(datos, MONTO_NO_ENTERO);
+  uint8_t bytes[sizeof(double)];
+  memcpy(bytes, &monto, sizeof(double));
+  datos.insert(datos.end(), bytes, bytes + sizeof(double));
+}
+
+double leer_monto(const vector<uint8_t>& datos, size_t& pos) {
+  uint64_t valor = leer_varint(datos, pos);
+  if (valor != MONTO_NO_ENTERO) {
+    return static_cast<double>(valor >> 1);
+  }
+  double monto;
+  memcpy(&monto, &datos[pos], sizeof(double));
+  pos += sizeof(double);
+  return monto;
+}
+
+} // namespace
+
+EstadisticasMemoria& EstadisticasMemoria::operator+=(const EstadisticasMemoria& otras) {
+  transacciones_calientes += otras.transacciones_calientes;
+  transacciones_frias += otras.transacciones_frias;
+  dias_calientes += otras.dias_calientes;
+  dias_frios += otras.dias_frios;
+  bytes_calientes += otras.bytes_calientes;
+  bytes_frios += otras.bytes_frios;
+  bytes_ranking += otras.bytes_ranking;
+  return *this;
+}
+
+//------------------------------------------------------------------------------
+// TransaccionesComprimidas
+//------------------------------------------------------------------------------
+
+TransaccionesComprimidas::TransaccionesComprimidas()
+  : _cantidad(0)
+  , _bytes(0)
+  , _ultimo_timestamp(0)
+  , _ultima_secuencia(0)
+{}
+
+void TransaccionesComprimidas::agregar(const vector<Transaccion>& txs, size_t n, id_billetera propia) {
+  size_t i = 0;
+  while (i < n) {
+    // Completo el último bloque antes de empezar otro, así archivar de a poco
+    // no deja un bloque chico por cada llamada.
+    if (_bloques.empty() || _bloques.back().cantidad == TRANSACCIONES_POR_BLOQUE) {
+      Bloque nuevo;
+      nuevo.primer_timestamp = txs[i]._timestamp;
+      nuevo.primera_secuencia = txs[i].secuencia;
+      nuevo.cantidad = 0;
+      _bloques.push_back(std::move(nuevo));
+
+      _ultimo_timestamp = txs[i]._timestamp;
+      _ultima_secuencia = txs[i].secuencia;
+    }
+
+    Bloque& bloque = _bloques.back();
+    _bytes -= bloque.datos.capacity();
+    while (i < n && bloque.cantidad < TRANSACCIONES_POR_BLOQUE) {
+      const Transaccion& t = txs[i];
+      bool es_origen = t.origen == propia;
+      id_billetera otra = es_origen ? t.destino : t.origen;
+
+      escribir_varint(bloque.datos, t._timestamp - _ultimo_timestamp);
+      escribir_varint(bloque.datos, t.secuencia - _ultima_secuencia);
+      escribir_varint(bloque.datos, (static_cast<uint64_t>(otra) << 1) | es_origen);
+      escribir_monto(bloque.datos, t.monto);
+
+      _ultimo_timestamp = t._timestamp;
+      _ultima_secuencia = t.secuencia;
+      bloque.cantidad++;
+      _cantidad++;
+      i++;
+    }
+
+    bloque.datos.shrink_to_fit();
+    _bytes += bloque.datos.capacity();
+  }
+}
+
+void TransaccionesComprimidas::decodificar(const Bloque& bloque, id_billetera propia, vector<Transaccion>& resultado) {
+  size_t pos = 0;
+  timestamp actual = bloque.primer_timestamp;
+  id_transaccion secuencia = bloque.primera_secuencia;
+  for (unsigned int i = 0; i < bloque.cantidad; i++) {
+    actual += static_cast<timestamp>(leer_varint(bloque.datos, pos));
+    secuencia += static_cast<id_transaccion>(leer_varint(bloque.datos, pos));
+    uint64_t otra_y_sentido = leer_varint(bloque.datos, pos);
+    id_billetera otra = static_cast<id_billetera>(otra_y_sentido >> 1);
+    bool es_origen = otra_y_sentido & 1;
+    double monto = leer_monto(bloque.datos, pos);
+
+    if (es_origen) {
+      resultado.push_back({propia, otra, monto, actual, secuencia});
+    } else {
+      resultado.push_back({otra, propia, monto, actual, secuencia});
+    }
+  }
+}
+
+void TransaccionesComprimidas::ultimas(size_t k, id_billetera propia, vector<Transaccion>& resultado) const {
+  vector<Transaccion> bloque_decodificado;
+  for (size_t b = _bloques.size(); b > 0 && k > 0; b--) {
+    bloque_decodificado.clear();
+    decodificar(_bloques[b - 1], propia, bloque_decodificado);
+    for (size_t i = bloque_decodificado.size(); i > 0 && k > 0; i--, k--) {
+      resultado.push_back(bloque_decodificado[i - 1]);
+    }
+  }
+}
+
+void TransaccionesComprimidas::ultimas_hasta(timestamp t, size_t k, id_billetera propia, vector<Transaccion>& resultado) const {
+  // Primer bloque que empieza después de `t`; los anteriores pueden tener transacciones hasta `t`.
+  auto siguiente = upper_bound(_bloques.begin(), _bloques.end(), t,
+    [](timestamp t, const Bloque& bloque) { return t < bloque.primer_timestamp; });
+
+  vector<Transaccion> bloque_decodificado;
+  for (size_t b = siguiente - _bloques.begin(); b > 0 && k > 0; b--) {
+    bloque_decodificado.clear();
+    decodificar(_bloques[b - 1], propia, bloque_decodificado);
+    for (size_t i = bloque_decodificado.size(); i > 0 && k > 0; i--) {
+      if (bloque_decodificado[i - 1]._timestamp <= t) {
+        resultado.push_back(bloque_decodificado[i - 1]);
+        k--;
+      }
+    }
+  }
+}
+
+size_t TransaccionesComprimidas::cantidad() const {
+  return _cantidad;
+}
+
+size_t TransaccionesComprimidas::bytes() const {
+  return _bytes + _bloques.capacity() * sizeof(Bloque);
+}
+
+//------------------------------------------------------------------------------
+// SaldosComprimidos
+//------------------------------------------------------------------------------
+
+SaldosComprimidos::SaldosComprimidos() {}
+
+void SaldosComprimidos::agregar(const vector<monto>& saldos, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (!_corridas.empty() && _corridas.back().second == saldos[i]) {
+      _corridas.back().first++;
+    } else {
+      _corridas.push_back({cantidad() + 1, saldos[i]});
+    }
+  }
+}
+
+monto SaldosComprimidos::consultar(size_t indice) const {
+  auto corrida = upper_bound(_corridas.begin(), _corridas.end(), indice,
+    [](size_t i, const pair<size_t, monto>& c) { return i < c.first; });
+  return corrida->second;
+}
+
+size_t SaldosComprimidos::cantidad() const {
+  return _corridas.empty() ? 0 : _corridas.back().first;
+}
+
+size_t SaldosComprimidos::bytes() const {
+  return _corridas.capacity() * sizeof(pair<size_t, monto>);
+}
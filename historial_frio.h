@@ -0,0 +1,142 @@
+#ifndef HISTORIAL_FRIO_H_
+#define HISTORIAL_FRIO_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "lib.h"
+
+using namespace std;
+
+/**
+ * Memoria usada por el historial de una o varias billeteras, separada en el
+ * nivel caliente (vectores sin comprimir) y el nivel frío (bloques comprimidos).
+ *
+ * `bytes_ranking` cuenta aparte las estructuras del ranking de destinatarios
+ * (el ranking actual, las salidas y los checkpoints del ranking histórico).
+ * No se archivan: quedan siempre en memoria, sin comprimir.
+ */
+struct EstadisticasMemoria {
+  size_t transacciones_calientes = 0;
+  size_t transacciones_frias = 0;
+  size_t dias_calientes = 0;
+  size_t dias_frios = 0;
+  size_t bytes_calientes = 0;
+  size_t bytes_frios = 0;
+  size_t bytes_ranking = 0;
+
+  EstadisticasMemoria& operator+=(const EstadisticasMemoria& otras);
+};
+
+/**
+ * Transacciones de una billetera archivadas en bloques comprimidos.
+ *
+ * Cada bloque guarda hasta TRANSACCIONES_POR_BLOQUE transacciones consecutivas.
+ * Dentro del bloque cada transacción se codifica como:
+ *   - varint: diferencia de timestamp con la transacción anterior del bloque
+ *   - varint: diferencia de secuencia con la transacción anterior del bloque
+ *   - varint: id de la otra billetera, con el bit menos significativo indicando
+ *     si la billetera propia fue el origen
+ *   - varint: monto, si es entero; si no, una marca seguida de los 8 bytes del double
+ *
+ * Cada llamada a `agregar` completa primero el último bloque, así que todos
+ * los bloques menos el último están llenos.
+ *
+ * Invariante: las transacciones están en orden cronológico, en bloques y
+ * dentro de cada bloque.
+ */
+class TransaccionesComprimidas {
+  public:
+    TransaccionesComprimidas();
+
+    /**
+     * Agrega al final las transacciones `txs`, en las que participó la
+     * billetera `propia`. Deben ser posteriores a todas las ya archivadas.
+     *
+     * Complejidad: O(n + TRANSACCIONES_POR_BLOQUE), donde n es la cantidad de
+     * transacciones agregadas
+     */
+    void agregar(const vector<Transaccion>& txs, size_t n, id_billetera propia);
+
+    /**
+     * Agrega a `resultado` las últimas `k` transacciones archivadas, de la más
+     * reciente a la más antigua.
+     *
+     * Complejidad: O(k + TRANSACCIONES_POR_BLOQUE)
+     */
+    void ultimas(size_t k, id_billetera propia, vector<Transaccion>& resultado) const;
+
+    /**
+     * Igual que `ultimas`, pero sólo considera las transacciones con timestamp
+     * menor o igual a `t`.
+     *
+     * Complejidad: O(log(bloques) + k + TRANSACCIONES_POR_BLOQUE)
+     */
+    void ultimas_hasta(timestamp t, size_t k, id_billetera propia, vector<Transaccion>& resultado) const;
+
+    /** Cantidad de transacciones archivadas. Complejidad: O(1) */
+    size_t cantidad() const;
+
+    /** Memoria ocupada por los bloques. Complejidad: O(1) */
+    size_t bytes() const;
+
+    static const unsigned int TRANSACCIONES_POR_BLOQUE = 128;
+
+  private:
+    struct Bloque {
+      timestamp primer_timestamp;
+      id_transaccion primera_secuencia;
+      unsigned int cantidad;
+      vector<uint8_t> datos;
+    };
+
+    /** Decodifica todas las transacciones de `bloque` en orden cronológico. */
+    static void decodificar(const Bloque& bloque, id_billetera propia, vector<Transaccion>& resultado);
+
+    vector<Bloque> _bloques;
+    size_t _cantidad;
+    size_t _bytes;
+
+    /** Timestamp y secuencia de la última transacción archivada, para seguir el último bloque. */
+    timestamp _ultimo_timestamp;
+    id_transaccion _ultima_secuencia;
+};
+
+/**
+ * Saldos al fin de cada día archivados con run-length encoding: cada corrida
+ * guarda un saldo y el índice del día siguiente al último de la corrida.
+ *
+ * Invariante: los índices de fin de corrida son estrictamente crecientes y dos
+ * corridas consecutivas tienen saldos distintos.
+ */
+class SaldosComprimidos {
+  public:
+    SaldosComprimidos();
+
+    /**
+     * Agrega al final los primeros `n` saldos de `saldos`.
+     *
+     * Complejidad: O(n)
+     */
+    void agregar(const vector<monto>& saldos, size_t n);
+
+    /**
+     * Devuelve el saldo del día `indice`, contado desde el primero archivado.
+     *
+     * Se asume como precondición que `indice < cantidad()`.
+     *
+     * Complejidad: O(log(R)), donde R es la cantidad de corridas
+     */
+    monto consultar(size_t indice) const;
+
+    /** Cantidad de días archivados. Complejidad: O(1) */
+    size_t cantidad() const;
+
+    /** Memoria ocupada por las corridas. Complejidad: O(1) */
+    size_t bytes() const;
+
+  private:
+    vector<pair<size_t, monto>> _corridas;
+};
+
+#endif // HISTORIAL_FRIO_H_
@@ -11,6 +11,8 @@ struct Transaccion {
     id_billetera destino;
     double monto;
     timestamp _timestamp;
+    /** Número de secuencia asignado por la blockchain al registrarla. Empieza en 1. */
+    id_transaccion secuencia;
 };
 
 #endif // LIB_H_
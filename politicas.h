@@ -0,0 +1,51 @@
+#ifndef POLITICAS_H_
+#define POLITICAS_H_
+
+#include <type_traits>
+
+/**
+ * Políticas de compilación para `BlockchainGenerica` y `BilleteraGenerica`.
+ *
+ * Cada política indica qué estructuras derivadas mantiene una billetera:
+ *   - HISTORIAL: las transacciones en las que participó (`ultimas_transacciones`)
+ *   - SALDOS_DIARIOS: el saldo al fin de cada día (`saldo_al_fin_del_dia`)
+ *   - RANKING: las transferencias por destinatario (`detinatarios_mas_frecuentes`)
+ *   - RANKING_HISTORICO: los destinos enviados y checkpoints del ranking para
+ *     consultarlo en el pasado (`detinatarios_mas_frecuentes_al`). Requiere RANKING.
+ *
+ * Las estructuras deshabilitadas no ocupan memoria ni se actualizan al
+ * notificar una transacción, y las consultas asociadas no compilan.
+ *
+ * Para agregar una política nueva hay que instanciarla explícitamente al final
+ * de billetera.cpp, blockchain.cpp y shards.cpp.
+ */
+
+/** Mantiene todas las estructuras. Es la configuración por defecto. */
+struct PoliticaCompleta {
+  static constexpr bool HISTORIAL = true;
+  static constexpr bool SALDOS_DIARIOS = true;
+  static constexpr bool RANKING = true;
+  static constexpr bool RANKING_HISTORICO = true;
+};
+
+/** Sólo mantiene el saldo actual de cada billetera. */
+struct PoliticaSoloSaldo {
+  static constexpr bool HISTORIAL = false;
+  static constexpr bool SALDOS_DIARIOS = false;
+  static constexpr bool RANKING = false;
+  static constexpr bool RANKING_HISTORICO = false;
+};
+
+/** Tipo vacío que ocupa el lugar de una estructura deshabilitada. */
+template <class T>
+struct Ausente {};
+
+/**
+ * `T` si la estructura está habilitada, `Ausente<T>` si no. Se usa junto con
+ * `[[no_unique_address]]` para que las estructuras deshabilitadas no ocupen
+ * memoria.
+ */
+template <bool habilitado, class T>
+using Opcional = std::conditional_t<habilitado, T, Ausente<T>>;
+
+#endif // POLITICAS_H_
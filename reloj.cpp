@@ -0,0 +1,111 @@
+#include <chrono>
+#include <ctime>
+
+#include "calendario.h"
+#include "reloj.h"
+
+using namespace std;
+
+namespace {
+
+timestamp tiempo_del_sistema() {
+  return static_cast<timestamp>(std::time(nullptr));
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// RelojCalendario
+//------------------------------------------------------------------------------
+
+timestamp RelojCalendario::ahora() {
+  return Calendario::tiempo_actual();
+}
+
+RelojCalendario* RelojCalendario::global() {
+  static RelojCalendario instancia;
+  return &instancia;
+}
+
+//------------------------------------------------------------------------------
+// RelojSistema
+//------------------------------------------------------------------------------
+
+timestamp RelojSistema::ahora() {
+  return tiempo_del_sistema();
+}
+
+//------------------------------------------------------------------------------
+// RelojGrueso
+//------------------------------------------------------------------------------
+
+RelojGrueso::RelojGrueso(unsigned int milisegundos_refresco)
+  : _actual(tiempo_del_sistema())
+  , _milisegundos_refresco(milisegundos_refresco)
+  , _detenido(false)
+{
+  _hilo = thread([this] {
+    unique_lock<mutex> lock(_mutex);
+    while (!_detener.wait_for(lock, chrono::milliseconds(_milisegundos_refresco), [this] { return _detenido; })) {
+      _actual.store(tiempo_del_sistema(), memory_order_relaxed);
+    }
+  });
+}
+
+RelojGrueso::~RelojGrueso() {
+  {
+    lock_guard<mutex> lock(_mutex);
+    _detenido = true;
+  }
+  _detener.notify_one();
+  _hilo.join();
+}
+
+timestamp RelojGrueso::ahora() {
+  return _actual.load(memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// RelojManual
+//------------------------------------------------------------------------------
+
+RelojManual::RelojManual(timestamp inicial)
+  : _actual(inicial)
+{}
+
+timestamp RelojManual::ahora() {
+  return _actual.load(memory_order_relaxed);
+}
+
+void RelojManual::fijar(timestamp t) {
+  _actual.store(t, memory_order_relaxed);
+}
+
+void RelojManual::avanzar(timestamp segundos) {
+  _actual.fetch_add(segundos, memory_order_relaxed);
+}
+
+void RelojManual::avanzar_un_dia() {
+  avanzar(DiaEnCurso::DURACION_DIA);
+}
+
+void RelojManual::avanzar_un_minuto() {
+  avanzar(60);
+}
+
+//------------------------------------------------------------------------------
+// DiaEnCurso
+//------------------------------------------------------------------------------
+
+DiaEnCurso::DiaEnCurso()
+  : _principio(0)
+  , _fin(0)
+  , _indice(0)
+{}
+
+int DiaEnCurso::recalcular(timestamp t) {
+  _indice = static_cast<int>(t / DURACION_DIA);
+  _principio = static_cast<timestamp>(_indice) * DURACION_DIA;
+  _fin = _principio + DURACION_DIA;
+  return _indice;
+}
@@ -0,0 +1,122 @@
+#ifndef RELOJ_H_
+#define RELOJ_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "lib.h"
+
+/**
+ * Fuente del tiempo actual de una blockchain. Cada blockchain usa la suya, de
+ * modo que blockchains independientes no comparten estado global y pueden
+ * ejecutarse en hilos distintos.
+ *
+ * Todas las implementaciones pueden usarse desde varios hilos a la vez.
+ */
+class Reloj {
+  public:
+    virtual ~Reloj() {}
+
+    /**
+     * Retorna el tiempo actual.
+     *
+     * Complejidad: O(1)
+     */
+    virtual timestamp ahora() = 0;
+};
+
+/**
+ * Delega en `Calendario::tiempo_actual`, así que respeta `Calendario::fijar`.
+ * Es el reloj por defecto de las blockchains, para mantener el comportamiento
+ * que esperan los tests.
+ */
+class RelojCalendario : public Reloj {
+  public:
+    timestamp ahora() override;
+
+    /** Instancia compartida por las blockchains que no indican reloj. */
+    static RelojCalendario* global();
+};
+
+/** Tiempo real del sistema, consultado en cada llamada. */
+class RelojSistema : public Reloj {
+  public:
+    timestamp ahora() override;
+};
+
+/**
+ * Tiempo real del sistema, actualizado por un hilo propio cada
+ * `milisegundos_refresco`. `ahora` sólo lee un valor en memoria, a cambio de
+ * poder atrasar hasta ese intervalo.
+ */
+class RelojGrueso : public Reloj {
+  public:
+    explicit RelojGrueso(unsigned int milisegundos_refresco = 100);
+    ~RelojGrueso();
+
+    RelojGrueso(const RelojGrueso&) = delete;
+    RelojGrueso& operator=(const RelojGrueso&) = delete;
+
+    timestamp ahora() override;
+
+  private:
+    std::atomic<timestamp> _actual;
+    const unsigned int _milisegundos_refresco;
+    std::mutex _mutex;
+    std::condition_variable _detener;
+    bool _detenido;
+    std::thread _hilo;
+};
+
+/** Tiempo controlado a mano, para simulaciones y tests deterministas. */
+class RelojManual : public Reloj {
+  public:
+    explicit RelojManual(timestamp inicial = 0);
+
+    timestamp ahora() override;
+
+    void fijar(timestamp t);
+    void avanzar(timestamp segundos);
+    void avanzar_un_dia();
+    void avanzar_un_minuto();
+
+  private:
+    std::atomic<timestamp> _actual;
+};
+
+/**
+ * Límites del día de la última consulta. Mientras los timestamps consultados
+ * caigan en ese día, el índice del día sale de dos comparaciones en vez de una
+ * división; al cambiar de día se recalculan los límites.
+ *
+ * No puede usarse desde varios hilos a la vez; cada blockchain tiene el suyo.
+ */
+class DiaEnCurso {
+  public:
+    DiaEnCurso();
+
+    /**
+     * Retorna el índice del día de `t` (t / DURACION_DIA).
+     *
+     * Complejidad: O(1)
+     */
+    int indice(timestamp t) {
+      if (t >= _principio && t < _fin) {
+        return _indice;
+      }
+      return recalcular(t);
+    }
+
+    static const timestamp DURACION_DIA = 86400;
+
+  private:
+    int recalcular(timestamp t);
+
+    timestamp _principio;
+    timestamp _fin;
+    int _indice;
+};
+
+#endif // RELOJ_H_
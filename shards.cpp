@@ -0,0 +1,211 @@
+#include <algorithm>
+
+#include "shards.h"
+#include "billetera.h"
+
+using namespace std;
+
+template <class Politica>
+CoordinadorShards<Politica>::Shard::Shard(id_billetera primer_id, id_billetera paso, Reloj* reloj)
+  : blockchain(primer_id, paso, reloj)
+  , terminar(false)
+{}
+
+template <class Politica>
+CoordinadorShards<Politica>::CoordinadorShards(unsigned int cantidad_shards, Reloj* reloj)
+  : _reloj(reloj == nullptr ? RelojCalendario::global() : reloj)
+  , _siguiente_shard(0)
+{
+  for (unsigned int i = 0; i < cantidad_shards; i++) {
+    // El id 0 está reservado para las transacciones semilla.
+    _shards.push_back(make_unique<Shard>(i + 1, cantidad_shards, _reloj));
+  }
+
+  for (unsigned int i = 0; i < cantidad_shards; i++) {
+    _shards[i]->hilo = thread(atender, _shards[i].get());
+  }
+}
+
+template <class Politica>
+CoordinadorShards<Politica>::~CoordinadorShards() {
+  for (auto& shard : _shards) {
+    {
+      lock_guard<mutex> lock(shard->mutex_tareas);
+      shard->terminar = true;
+    }
+    shard->hay_tareas.notify_one();
+  }
+
+  for (auto& shard : _shards) {
+    shard->hilo.join();
+  }
+}
+
+template <class Politica>
+void CoordinadorShards<Politica>::atender(Shard* shard) {
+  while (true) {
+    function<void()> tarea;
+    {
+      unique_lock<mutex> lock(shard->mutex_tareas);
+      shard->hay_tareas.wait(lock, [shard] { return shard->terminar || !shard->tareas.empty(); });
+      if (shard->tareas.empty()) {
+        return;
+      }
+      tarea = std::move(shard->tareas.front());
+      shard->tareas.pop_front();
+    }
+    tarea();
+  }
+}
+
+template <class Politica>
+template <class F>
+auto CoordinadorShards<Politica>::ejecutar_en(unsigned int i, F operacion) -> decltype(operacion(declval<BlockchainGenerica<Politica>&>())) {
+  using Resultado = decltype(operacion(declval<BlockchainGenerica<Politica>&>()));
+
+  Shard* shard = _shards[i].get();
+  auto tarea = make_shared<packaged_task<Resultado()>>([shard, operacion] { return operacion(shard->blockchain); });
+  future<Resultado> resultado = tarea->get_future();
+
+  {
+    lock_guard<mutex> lock(shard->mutex_tareas);
+    shard->tareas.push_back([tarea] { (*tarea)(); });
+  }
+  shard->hay_tareas.notify_one();
+
+  return resultado.get();
+}
+
+template <class Politica>
+unsigned int CoordinadorShards<Politica>::cantidad_shards() const {
+  return _shards.size();
+}
+
+template <class Politica>
+unsigned int CoordinadorShards<Politica>::shard_de(id_billetera id) const {
+  return (id - 1) % _shards.size();
+}
+
+template <class Politica>
+id_billetera CoordinadorShards<Politica>::abrir_billetera() {
+  unsigned int i = _siguiente_shard++ % _shards.size();
+  return ejecutar_en(i, [](BlockchainGenerica<Politica>& blockchain) {
+    return blockchain.abrir_billetera()->id();
+  });
+}
+
+template <class Politica>
+bool CoordinadorShards<Politica>::transferir(id_billetera origen, id_billetera destino, double monto) {
+  if (origen == 0 || destino == 0) {
+    return false;
+  }
+
+  unsigned int shard_origen = shard_de(origen);
+  unsigned int shard_destino = shard_de(destino);
+
+  if (shard_origen == shard_destino) {
+    return ejecutar_en(shard_origen, [origen, destino, monto](BlockchainGenerica<Politica>& blockchain) {
+      BilleteraGenerica<Politica>* billetera = blockchain.billetera(origen);
+      return billetera != nullptr && blockchain.agregar_transaccion(billetera, destino, monto);
+    });
+  }
+
+  // Fase 1: reservar en el origen y preparar en el destino. Cada shard
+  // devuelve además el timestamp de su última transacción.
+  pair<bool, timestamp> reservado = ejecutar_en(shard_origen, [origen, monto](BlockchainGenerica<Politica>& blockchain) {
+    BilleteraGenerica<Politica>* billetera = blockchain.billetera(origen);
+    bool aceptado = billetera != nullptr && blockchain.reservar_debito(billetera, monto);
+    return make_pair(aceptado, blockchain.ultimo_timestamp());
+  });
+  if (!reservado.first) {
+    return false;
+  }
+
+  pair<bool, timestamp> preparado = ejecutar_en(shard_destino, [destino](BlockchainGenerica<Politica>& blockchain) {
+    return make_pair(blockchain.preparar_credito(destino), blockchain.ultimo_timestamp());
+  });
+  if (!preparado.first) {
+    ejecutar_en(shard_origen, [origen, monto](BlockchainGenerica<Politica>& blockchain) {
+      blockchain.cancelar_debito(origen, monto);
+    });
+    return false;
+  }
+
+  // Fase 2: confirmar en ambos. El destino puede haber registrado algo
+  // posterior desde que se preparó; el origen confirma con el timestamp que
+  // usó el destino.
+  timestamp t = max({_reloj->ahora(), reservado.second, preparado.second});
+  t = ejecutar_en(shard_destino, [origen, destino, monto, t](BlockchainGenerica<Politica>& blockchain) {
+    return blockchain.confirmar_credito(origen, destino, monto, t);
+  });
+  ejecutar_en(shard_origen, [origen, destino, monto, t](BlockchainGenerica<Politica>& blockchain) {
+    return blockchain.confirmar_debito(origen, destino, monto, t);
+  });
+
+  return true;
+}
+
+template <class Politica>
+monto CoordinadorShards<Politica>::saldo(id_billetera id) {
+  if (id == 0) {
+    return 0;
+  }
+
+  return ejecutar_en(shard_de(id), [id](BlockchainGenerica<Politica>& blockchain) -> monto {
+    BilleteraGenerica<Politica>* billetera = blockchain.billetera(id);
+    return billetera == nullptr ? 0 : billetera->saldo();
+  });
+}
+
+template <class Politica>
+vector<Transaccion> CoordinadorShards<Politica>::transacciones() {
+  vector<Transaccion> todas;
+
+  for (unsigned int i = 0; i < _shards.size(); i++) {
+    vector<Transaccion> del_shard = ejecutar_en(i, [this, i](BlockchainGenerica<Politica>& blockchain) {
+      vector<Transaccion> resultado;
+      for (const Transaccion& tx : blockchain.transacciones()) {
+        // Los créditos de transferencias entre shards ya están en el shard de origen.
+        bool credito_externo = tx.origen != 0 && shard_de(tx.origen) != i;
+        if (!credito_externo) {
+          resultado.push_back(tx);
+        }
+      }
+      return resultado;
+    });
+    todas.insert(todas.end(), del_shard.begin(), del_shard.end());
+  }
+
+  // Cada shard está en orden de secuencia, y los shards en orden de índice.
+  stable_sort(todas.begin(), todas.end(), [](const Transaccion& a, const Transaccion& b) {
+    return a._timestamp < b._timestamp;
+  });
+
+  return todas;
+}
+
+template <class Politica>
+size_t CoordinadorShards<Politica>::cantidad_billeteras() {
+  size_t total = 0;
+  for (unsigned int i = 0; i < _shards.size(); i++) {
+    total += ejecutar_en(i, [](BlockchainGenerica<Politica>& blockchain) {
+      return blockchain.cantidad_billeteras();
+    });
+  }
+  return total;
+}
+
+template <class Politica>
+EstadisticasMemoria CoordinadorShards<Politica>::estadisticas_memoria() {
+  EstadisticasMemoria total;
+  for (unsigned int i = 0; i < _shards.size(); i++) {
+    total += ejecutar_en(i, [](BlockchainGenerica<Politica>& blockchain) {
+      return blockchain.estadisticas_memoria();
+    });
+  }
+  return total;
+}
+
+// Instanciaciones explícitas de las políticas provistas en politicas.h.
+template class CoordinadorShards<PoliticaCompleta>;
+template class CoordinadorShards<PoliticaSoloSaldo>;
@@ -0,0 +1,145 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lib.h"
+#include "politicas.h"
+#include "historial_frio.h"
+#include "blockchain.h"
+#include "reloj.h"
+
+using namespace std;
+
+/**
+ * Reparte las billeteras entre varias blockchains (shards), cada una atendida
+ * por su propio hilo.
+ *
+ * El shard `i` de `n` asigna los ids i+1, i+1+n, i+1+2n, ..., de modo que el
+ * dueño de una billetera se obtiene de su id sin consultar ningún registro.
+ * Toda operación sobre un shard se encola y la ejecuta su hilo, así que las
+ * blockchains nunca se acceden concurrentemente; los métodos del coordinador
+ * pueden llamarse desde varios hilos a la vez.
+ *
+ * Las transferencias entre billeteras de un mismo shard se delegan en
+ * `agregar_transaccion`. Las transferencias entre shards usan el protocolo en
+ * dos fases de la blockchain: se reserva el monto en el shard del origen y se
+ * prepara el crédito en el del destino; si ambos aceptan se confirman los dos,
+ * y si no se cancela el que haya aceptado. La transacción queda registrada en
+ * ambos shards.
+ *
+ * El timestamp de una transferencia entre shards es el mayor entre el tiempo
+ * actual y el de la última transacción de cada shard al prepararse. Si un
+ * shard registra otra transacción posterior antes de confirmar, la
+ * confirmación usa el timestamp de ésa (ver `confirmar_credito`), así que los
+ * registros siguen en orden cronológico. El origen confirma con el timestamp
+ * que usó el destino, por lo que ambos registros coinciden salvo que el
+ * origen también haya registrado algo posterior en el medio.
+ */
+template <class Politica>
+class CoordinadorShards {
+  public:
+    /**
+     * Crea `cantidad_shards` blockchains y un hilo para cada una. Todas toman
+     * el tiempo de `reloj`, que se consulta desde los hilos de los shards y
+     * debe vivir más que el coordinador; si es `nullptr` se usa
+     * `RelojCalendario::global()`.
+     *
+     * Se asume como precondición que `cantidad_shards` es mayor a 0.
+     */
+    CoordinadorShards(unsigned int cantidad_shards, Reloj* reloj = nullptr);
+
+    /** Detiene los hilos, después de ejecutar las operaciones encoladas. */
+    ~CoordinadorShards();
+
+    CoordinadorShards(const CoordinadorShards&) = delete;
+    CoordinadorShards& operator=(const CoordinadorShards&) = delete;
+
+    /** Cantidad de shards. Complejidad: O(1) */
+    unsigned int cantidad_shards() const;
+
+    /**
+     * Shard dueño de la billetera `id`.
+     *
+     * Complejidad: O(1)
+     */
+    unsigned int shard_de(id_billetera id) const;
+
+    /**
+     * Abre una billetera en el shard siguiente (round robin) y devuelve su id.
+     *
+     * Complejidad: la de `abrir_billetera` en ese shard
+     */
+    id_billetera abrir_billetera();
+
+    /**
+     * Transfiere `monto` de `origen` a `destino`, con las mismas validaciones
+     * que `agregar_transaccion`. Devuelve `true` si y sólo si se registró.
+     *
+     * Complejidad: la de `agregar_transaccion` si ambas billeteras están en el
+     * mismo shard, o la de las dos fases en cada shard si no.
+     */
+    bool transferir(id_billetera origen, id_billetera destino, double monto);
+
+    /**
+     * Saldo actual de la billetera `id`, o 0 si no está registrada.
+     *
+     * Complejidad: O(log(B))
+     */
+    monto saldo(id_billetera id);
+
+    /**
+     * Transacciones de todos los shards ordenadas por timestamp (y, a igual
+     * timestamp, por shard y secuencia). Las transferencias entre shards
+     * aparecen una sola vez, con el registro del shard de origen.
+     *
+     * Complejidad: O(T*log(T))
+     */
+    vector<Transaccion> transacciones();
+
+    /** Cantidad de billeteras abiertas en todos los shards. Complejidad: O(N) */
+    size_t cantidad_billeteras();
+
+    /** Memoria del historial y los rankings de todos los shards. Complejidad: O(B + P) */
+    EstadisticasMemoria estadisticas_memoria();
+
+  private:
+    struct Shard {
+      Shard(id_billetera primer_id, id_billetera paso, Reloj* reloj);
+
+      BlockchainGenerica<Politica> blockchain;
+      mutex mutex_tareas;
+      condition_variable hay_tareas;
+      deque<function<void()>> tareas;
+      bool terminar;
+      thread hilo;
+    };
+
+    /** Ciclo del hilo de un shard: ejecuta las tareas encoladas en orden. */
+    static void atender(Shard* shard);
+
+    /**
+     * Encola `operacion` en el shard `i`, espera a que su hilo la ejecute y
+     * devuelve el resultado.
+     */
+    template <class F>
+    auto ejecutar_en(unsigned int i, F operacion) -> decltype(operacion(declval<BlockchainGenerica<Politica>&>()));
+
+    vector<unique_ptr<Shard>> _shards;
+
+    /** Reloj de todos los shards. Da el timestamp de las transferencias entre shards. */
+    Reloj* _reloj;
+
+    /** Shard en el que se abrirá la próxima billetera. */
+    atomic<unsigned int> _siguiente_shard;
+};
+
+#endif
@@ -228,3 +228,67 @@ TEST_F(test_billetera, destinatarios_mas_frecuentes_solo_cuenta_transacciones_sa
     { billetera2->id(), billetera3->id() }
   );
 }
+
+TEST_F(test_billetera, billetera_solo_saldo_mantiene_el_saldo_sin_estructuras_derivadas) {
+  BlockchainSoloSaldo blockchain;
+
+  BilleteraSoloSaldo* billetera1 = blockchain.abrir_billetera();
+  BilleteraSoloSaldo* billetera2 = blockchain.abrir_billetera();
+
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 30));
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 71));
+
+  EXPECT_EQ(billetera1->saldo(), 70);
+  EXPECT_EQ(billetera2->saldo(), 130);
+  EXPECT_EQ(blockchain.calcular_saldo(billetera1), 70);
+
+  EXPECT_TRUE(blockchain.cerrar_billetera(billetera1, billetera2->id()));
+  EXPECT_EQ(billetera2->saldo(), 200);
+  EXPECT_EQ(blockchain.cantidad_billeteras(), 1);
+
+  EXPECT_LT(sizeof(BilleteraSoloSaldo), sizeof(Billetera));
+  EXPECT_LT(sizeof(BlockchainSoloSaldo), sizeof(Blockchain));
+}
+
+TEST_F(test_billetera, consultas_al_pasado_coinciden_con_las_consultas_en_ese_momento) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  Billetera* billetera = blockchain.abrir_billetera();
+  vector<Billetera*> destinos = blockchain.abrir_billeteras(8);
+
+  vector<timestamp> momentos;
+  vector<vector<Transaccion>> ultimas;
+  vector<vector<id_billetera>> destinatarios;
+
+  for (int i = 0; i < 400; i++) {
+    Calendario::avanzar_un_minuto();
+    Billetera* destino = destinos[(i * i + i / 3) % 8];
+    if (i % 5 == 0) {
+      agregar_transaccion(blockchain, destino, billetera, 4);
+    } else {
+      agregar_transaccion(blockchain, billetera, destino, 1);
+    }
+    if (i == 200) {
+      // Parte del historial pasa al nivel frío.
+      blockchain.archivar_historial(100 * 60);
+    }
+
+    momentos.push_back(Calendario::tiempo_actual());
+    ultimas.push_back(billetera->ultimas_transacciones(6));
+    destinatarios.push_back(billetera->detinatarios_mas_frecuentes(8));
+  }
+
+  for (size_t m = 0; m < momentos.size(); m++) {
+    vector<Transaccion> ultimas_al = billetera->ultimas_transacciones_al(momentos[m], 6);
+    ASSERT_EQ(ultimas_al.size(), ultimas[m].size());
+    for (size_t i = 0; i < ultimas_al.size(); i++) {
+      EXPECT_EQ(ultimas_al[i].secuencia, ultimas[m][i].secuencia);
+    }
+    chequear_ids_billeteras(billetera->detinatarios_mas_frecuentes_al(momentos[m], 8), destinatarios[m]);
+  }
+
+  // Antes de la primera transferencia enviada sólo está la semilla.
+  EXPECT_EQ(billetera->ultimas_transacciones_al(0, 10).size(), 1);
+  EXPECT_TRUE(billetera->detinatarios_mas_frecuentes_al(0, 3).empty());
+}
@@ -2,6 +2,7 @@
 #include <cassert>
 #include <gtest/gtest.h>
 
+#include "../calendario.h"
 #include "../lib.h"
 #include "../blockchain.h"
 #include "../billetera.h"
@@ -105,3 +106,279 @@ TEST(tests_blockchain,no_permite_hacerse_transferencias_a_uno_mismo) {
   EXPECT_EQ(resultado, false);
   EXPECT_EQ(blockchain.transacciones().size(), 1); // sólo transacción semilla
 }
+
+TEST(tests_blockchain,abrir_billeteras_registra_billeteras_con_ids_consecutivos_y_sus_semillas) {
+  Blockchain blockchain;
+
+  Billetera* suelta = blockchain.abrir_billetera();
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(3);
+  Billetera* otra_suelta = blockchain.abrir_billetera();
+
+  EXPECT_EQ(billeteras.size(), 3);
+  EXPECT_EQ(blockchain.transacciones().size(), 5);
+  for (unsigned int i = 0; i < billeteras.size(); i++) {
+    EXPECT_EQ(billeteras[i]->id(), suelta->id() + 1 + i);
+    EXPECT_EQ(billeteras[i]->saldo(), 100);
+    EXPECT_EQ(blockchain.calcular_saldo(billeteras[i]), 100);
+    EXPECT_EQ(billeteras[i]->ultimas_transacciones(5).size(), 1);
+  }
+  EXPECT_EQ(otra_suelta->id(), suelta->id() + 4);
+
+  agregar_transaccion(blockchain, billeteras[0], billeteras[2], 30);
+  agregar_transaccion(blockchain, billeteras[2], suelta, 10);
+  agregar_transaccion(blockchain, otra_suelta, billeteras[1], 5);
+
+  EXPECT_EQ(billeteras[0]->saldo(), 70);
+  EXPECT_EQ(billeteras[1]->saldo(), 105);
+  EXPECT_EQ(billeteras[2]->saldo(), 120);
+  chequear_ids_billeteras(billeteras[2]->detinatarios_mas_frecuentes(1), { suelta->id() });
+}
+
+TEST(tests_blockchain,las_transacciones_tienen_secuencias_consecutivas) {
+  Blockchain blockchain;
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(2);
+  agregar_transaccion(blockchain, billetera1, billeteras[0], 10);
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billeteras[0]->id(), 1000));
+
+  id_transaccion esperada = 1;
+  for (const Transaccion& tx : blockchain.transacciones()) {
+    EXPECT_EQ(tx.secuencia, esperada++);
+  }
+  EXPECT_EQ(blockchain.ultima_secuencia(), 4);
+
+  vector<Transaccion> lote;
+  blockchain.transacciones_desde(2, 10, lote);
+  EXPECT_EQ(lote.size(), 2);
+  EXPECT_EQ(lote[0].secuencia, 3);
+  chequear_transaccion(lote[1], billetera1->id(), billeteras[0]->id(), 10);
+}
+
+TEST(tests_blockchain,suscripcion_entrega_solo_transacciones_nuevas_en_lotes) {
+  Blockchain blockchain;
+
+  Suscripcion* desde_el_principio = blockchain.suscribir(0, 0);
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Suscripcion* desde_la_segunda = blockchain.suscribir(1, 0);
+
+  agregar_transaccion(blockchain, billetera1, billetera2, 1);
+  agregar_transaccion(blockchain, billetera1, billetera2, 2);
+
+  vector<Transaccion> lote;
+  EXPECT_EQ(blockchain.leer(desde_el_principio, 3, lote), 3);
+  EXPECT_EQ(lote[0].secuencia, 1);
+  EXPECT_EQ(lote[2].secuencia, 3);
+  EXPECT_EQ(blockchain.pendientes(desde_el_principio), 1);
+
+  lote.clear();
+  EXPECT_EQ(blockchain.leer(desde_el_principio, 10, lote), 1);
+  EXPECT_EQ(lote[0].secuencia, 4);
+  lote.clear();
+  EXPECT_EQ(blockchain.leer(desde_el_principio, 10, lote), 0);
+
+  lote.clear();
+  EXPECT_EQ(blockchain.leer(desde_la_segunda, 10, lote), 3);
+  EXPECT_EQ(lote[0].secuencia, 2);
+
+  blockchain.cancelar_suscripcion(desde_el_principio);
+  blockchain.cancelar_suscripcion(desde_la_segunda);
+}
+
+TEST(tests_blockchain,suscripcion_con_capacidad_frena_transacciones_hasta_que_se_lea) {
+  Blockchain blockchain;
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Suscripcion* suscripcion = blockchain.suscribir(blockchain.ultima_secuencia(), 2);
+
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1000));
+  EXPECT_FALSE(blockchain.hay_contrapresion());
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_TRUE(blockchain.hay_contrapresion());
+  EXPECT_EQ(billetera1->saldo(), 98);
+
+  vector<Transaccion> lote;
+  blockchain.leer(suscripcion, 1, lote);
+  EXPECT_FALSE(blockchain.hay_contrapresion());
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_EQ(blockchain.pendientes(suscripcion), 2);
+
+  // Las aperturas no se frenan, así que los pendientes pueden superar la capacidad.
+  blockchain.abrir_billetera();
+  EXPECT_EQ(blockchain.pendientes(suscripcion), 3);
+  EXPECT_TRUE(blockchain.hay_contrapresion());
+}
+
+TEST(tests_blockchain,la_contrapresion_depende_de_la_suscripcion_mas_atrasada) {
+  Blockchain blockchain;
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Suscripcion* sin_limite = blockchain.suscribir(0, 0);
+  Suscripcion* chica = blockchain.suscribir(blockchain.ultima_secuencia(), 1);
+  Suscripcion* grande = blockchain.suscribir(blockchain.ultima_secuencia(), 3);
+
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_TRUE(blockchain.hay_contrapresion());
+
+  // Al leer, la más atrasada pasa a ser la grande.
+  vector<Transaccion> lote;
+  blockchain.leer(chica, 10, lote);
+  EXPECT_FALSE(blockchain.hay_contrapresion());
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_TRUE(blockchain.hay_contrapresion());
+  blockchain.leer(chica, 10, lote);
+  EXPECT_FALSE(blockchain.hay_contrapresion());
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+
+  // Ahora frenan las dos; al cancelarlas deja de haber contrapresión.
+  EXPECT_EQ(blockchain.pendientes(grande), 3);
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  blockchain.cancelar_suscripcion(grande);
+  EXPECT_TRUE(blockchain.hay_contrapresion());
+  blockchain.cancelar_suscripcion(chica);
+  EXPECT_FALSE(blockchain.hay_contrapresion());
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_EQ(blockchain.pendientes(sin_limite), 6);
+}
+
+TEST(tests_blockchain,cerrar_billetera_transfiere_el_saldo_y_rechaza_transferencias_posteriores) {
+  Blockchain blockchain;
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(2);
+  id_billetera id1 = billetera1->id();
+  id_billetera id_en_bloque = billeteras[0]->id();
+
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+
+  // Sin destino no se puede cerrar una billetera con saldo.
+  EXPECT_FALSE(blockchain.cerrar_billetera(billetera1, 0));
+  EXPECT_EQ(blockchain.cantidad_billeteras(), 4);
+
+  EXPECT_TRUE(blockchain.cerrar_billetera(billetera1, billetera2->id()));
+  EXPECT_TRUE(blockchain.cerrar_billetera(billeteras[0], billetera2->id()));
+  EXPECT_EQ(blockchain.cantidad_billeteras(), 2);
+  EXPECT_EQ(billetera2->saldo(), 300);
+
+  // El registro conserva todo el historial, incluidas las transferencias de cierre.
+  EXPECT_EQ(blockchain.transacciones().size(), 7);
+  chequear_transaccion(*blockchain.transacciones().rbegin(), id_en_bloque, billetera2->id(), 100);
+
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera2, id1, 1));
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera2, id_en_bloque, 1));
+  agregar_transaccion(blockchain, billetera2, billeteras[1], 1);
+}
+
+TEST(tests_blockchain,cerrar_billeteras_sueltas_y_de_varios_bloques) {
+  Blockchain blockchain;
+
+  // Alterno bloques y billeteras sueltas, así los bloques quedan separados.
+  vector<Billetera*> sueltas;
+  vector<vector<Billetera*>> bloques;
+  for (int i = 0; i < 20; i++) {
+    bloques.push_back(blockchain.abrir_billeteras(3));
+    sueltas.push_back(blockchain.abrir_billetera());
+  }
+  Billetera* destino = sueltas.back();
+
+  for (int i = 0; i < 19; i++) {
+    EXPECT_TRUE(blockchain.cerrar_billetera(sueltas[i], destino->id()));
+    EXPECT_TRUE(blockchain.cerrar_billetera(bloques[i][1], destino->id()));
+  }
+  EXPECT_EQ(blockchain.cantidad_billeteras(), 20 * 4 - 19 * 2);
+  EXPECT_EQ(destino->saldo(), 100 + 19 * 2 * 100);
+  agregar_transaccion(blockchain, bloques[7][2], bloques[12][0], 5);
+}
+
+TEST(tests_blockchain,cerrar_todas_las_billeteras_de_un_bloque_lo_libera) {
+  Blockchain blockchain;
+
+  vector<Billetera*> primero = blockchain.abrir_billeteras(3);
+  vector<Billetera*> segundo = blockchain.abrir_billeteras(3);
+  vector<Billetera*> tercero = blockchain.abrir_billeteras(3);
+
+  for (Billetera* billetera : segundo) {
+    EXPECT_TRUE(blockchain.cerrar_billetera(billetera, primero[0]->id()));
+  }
+  EXPECT_EQ(primero[0]->saldo(), 400);
+
+  // Los otros bloques siguen funcionando después de liberar el del medio.
+  agregar_transaccion(blockchain, primero[0], tercero[2], 50);
+  EXPECT_TRUE(blockchain.cerrar_billetera(tercero[0], tercero[1]->id()));
+  EXPECT_EQ(tercero[1]->saldo(), 200);
+
+  for (Billetera* billetera : primero) {
+    EXPECT_TRUE(blockchain.cerrar_billetera(billetera, tercero[2]->id()));
+  }
+  EXPECT_EQ(tercero[2]->saldo(), 150 + 350 + 200);
+  EXPECT_EQ(blockchain.cantidad_billeteras(), 2);
+}
+
+TEST(tests_blockchain,saldos_al_fin_del_dia_calcula_el_saldo_de_todas_las_billeteras) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(10000);
+  agregar_transaccion(blockchain, billeteras[0], billeteras[1], 10);
+  Calendario::avanzar_un_dia();
+  agregar_transaccion(blockchain, billeteras[1], billeteras[2], 50);
+  Billetera* nueva = blockchain.abrir_billetera();
+  EXPECT_TRUE(blockchain.cerrar_billetera(billeteras[3], billeteras[4]->id()));
+
+  vector<monto> saldos(blockchain.cantidad_billeteras());
+  vector<id_billetera> ids(blockchain.cantidad_billeteras());
+  blockchain.saldos_al_fin_del_dia(Calendario::dia(0), saldos.data(), ids.data(), 4);
+
+  EXPECT_EQ(ids[0], billeteras[0]->id());
+  EXPECT_EQ(ids[3], billeteras[4]->id());
+  EXPECT_EQ(ids.back(), nueva->id());
+  for (size_t i = 0; i < saldos.size(); i++) {
+    Billetera* billetera = i < 3 ? billeteras[i] : (i + 1 < saldos.size() ? billeteras[i + 1] : nueva);
+    EXPECT_EQ(saldos[i], billetera->saldo_al_fin_del_dia(Calendario::dia(0)));
+  }
+  EXPECT_EQ(saldos[1], 110);
+  EXPECT_EQ(saldos.back(), 0); // abierta el día 1
+
+  vector<id_billetera> pedidas = {billeteras[2]->id(), billeteras[3]->id(), nueva->id(), billeteras[1]->id()};
+  vector<monto> saldos_pedidos(pedidas.size());
+  blockchain.saldos_al_fin_del_dia(Calendario::dia(1), pedidas, saldos_pedidos.data());
+  EXPECT_EQ(saldos_pedidos, vector<monto>({150, 0, 100, 60}));
+
+  Calendario::restaurar();
+}
+
+TEST(tests_blockchain,saldos_al_fin_del_dia_sigue_a_las_billeteras_despues_de_compactar) {
+  RelojManual reloj(Calendario::dia(0));
+  Blockchain blockchain(&reloj);
+
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(6);
+  for (int i = 0; i < 4; i++) {
+    billeteras.push_back(blockchain.abrir_billetera());
+  }
+  agregar_transaccion(blockchain, billeteras[0], billeteras[9], 10);
+  reloj.avanzar_un_dia();
+
+  // Cerrar más de la mitad compacta la copia contigua y mueve las que quedan.
+  for (int i : {1, 2, 4, 5, 6, 8}) {
+    EXPECT_TRUE(blockchain.cerrar_billetera(billeteras[i], billeteras[3]->id()));
+  }
+  reloj.avanzar_un_dia();
+  agregar_transaccion(blockchain, billeteras[3], billeteras[7], 200);
+  agregar_transaccion(blockchain, billeteras[9], billeteras[0], 5);
+
+  vector<Billetera*> abiertas = {billeteras[0], billeteras[3], billeteras[7], billeteras[9]};
+  vector<monto> saldos(abiertas.size());
+  for (int d = 0; d < 4; d++) {
+    blockchain.saldos_al_fin_del_dia(Calendario::dia(d), saldos.data());
+    for (size_t i = 0; i < abiertas.size(); i++) {
+      EXPECT_EQ(saldos[i], abiertas[i]->saldo_al_fin_del_dia(Calendario::dia(d))) << d << " " << i;
+    }
+  }
+  EXPECT_EQ(saldos, vector<monto>({95, 500, 300, 105}));
+}
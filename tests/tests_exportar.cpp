@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../blockchain.h"
+#include "../billetera.h"
+#include "../exportar.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_exportar : public ::testing::Test {
+protected:
+    void SetUp() override {
+      Calendario::restaurar();
+      archivo = tmpfile();
+      ASSERT_NE(archivo, nullptr);
+    }
+
+    void TearDown() override {
+      fclose(archivo);
+      Calendario::restaurar();
+    }
+
+    string leer_archivo() {
+      string contenido;
+      char buffer[4096];
+      lseek(fileno(archivo), 0, SEEK_SET);
+      ssize_t leidos;
+      while ((leidos = read(fileno(archivo), buffer, sizeof(buffer))) > 0) {
+        contenido.append(buffer, leidos);
+      }
+      return contenido;
+    }
+
+    FILE* archivo;
+};
+
+TEST_F(test_exportar, exporta_csv_de_un_rango_de_secuencias) {
+  Blockchain blockchain;
+  Calendario::fijar(1000);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Calendario::avanzar_un_minuto();
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+  blockchain.agregar_transaccion(billetera2, billetera1->id(), 2.5);
+
+  ExportadorLedger exportador(blockchain.transacciones(), fileno(archivo), ExportadorLedger::CSV, 1, 3);
+  exportador.exportar_todo();
+
+  EXPECT_FALSE(exportador.error());
+  EXPECT_EQ(exportador.exportadas(), 2);
+  EXPECT_EQ(leer_archivo(),
+    "secuencia,timestamp,origen,destino,monto\n"
+    "2,1000,0," + to_string(billetera2->id()) + ",100\n"
+    "3,1060," + to_string(billetera1->id()) + "," + to_string(billetera2->id()) + ",10\n");
+}
+
+TEST_F(test_exportar, exporta_binario_de_un_rango_de_timestamps) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(2);
+  for (int i = 0; i < 10000; i++) {
+    Calendario::avanzar_un_minuto();
+    agregar_transaccion(blockchain, billeteras[i % 2], billeteras[(i + 1) % 2], 1);
+  }
+
+  // Minutos 101 a 200: secuencias 103 a 202.
+  ExportadorLedger exportador(blockchain.transacciones(), fileno(archivo), ExportadorLedger::BINARIO, 0, UINT32_MAX, 101 * 60, 200 * 60);
+  exportador.exportar_todo();
+  EXPECT_EQ(exportador.exportadas(), 100);
+
+  string contenido = leer_archivo();
+  ASSERT_EQ(contenido.size(), 16 + 100 * 24);
+  EXPECT_EQ(contenido.substr(0, 8), "TD3LEDGR");
+
+  uint32_t secuencia;
+  uint32_t timestamp_registro;
+  double monto;
+  memcpy(&secuencia, contenido.data() + 16, 4);
+  memcpy(&timestamp_registro, contenido.data() + 20, 4);
+  memcpy(&monto, contenido.data() + 16 + 16, 8);
+  EXPECT_EQ(secuencia, 103);
+  EXPECT_EQ(timestamp_registro, 101 * 60);
+  EXPECT_EQ(monto, 1);
+}
+
+TEST_F(test_exportar, la_exportacion_no_incluye_lo_registrado_despues_de_empezar) {
+  Blockchain blockchain;
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  ExportadorLedger exportador(blockchain.transacciones(), fileno(archivo), ExportadorLedger::BINARIO);
+  EXPECT_TRUE(exportador.avanzar(1));
+
+  // La blockchain sigue registrando transacciones mientras se exporta.
+  agregar_transaccion(blockchain, billetera1, billetera2, 1);
+  agregar_transaccion(blockchain, billetera2, billetera1, 1);
+
+  EXPECT_FALSE(exportador.avanzar(10));
+  EXPECT_EQ(exportador.exportadas(), 2);
+  EXPECT_EQ(leer_archivo().size(), 16 + 2 * 24);
+}
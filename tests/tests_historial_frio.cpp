@@ -0,0 +1,154 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../historial_frio.h"
+#include "../blockchain.h"
+#include "../billetera.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_historial_frio : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_historial_frio, transacciones_comprimidas_se_recuperan_intactas) {
+  vector<Transaccion> txs = {
+    {0, 7, 100, 1000, 3},
+    {7, 3000000000u, 12.5, 1000, 9},
+    {42, 7, 1, 90000, 10},
+  };
+  for (unsigned int i = 0; i < 300; i++) {
+    txs.push_back({7, i, static_cast<double>(i), 100000 + i * 60, 20 + i * 3});
+  }
+
+  TransaccionesComprimidas comprimidas;
+  comprimidas.agregar(txs, txs.size(), 7);
+  EXPECT_EQ(comprimidas.cantidad(), txs.size());
+  EXPECT_LT(comprimidas.bytes(), txs.size() * sizeof(Transaccion));
+
+  vector<Transaccion> ultimas;
+  comprimidas.ultimas(txs.size() + 5, 7, ultimas);
+  ASSERT_EQ(ultimas.size(), txs.size());
+  for (size_t i = 0; i < txs.size(); i++) {
+    const Transaccion& esperada = txs[txs.size() - 1 - i];
+    EXPECT_EQ(ultimas[i].origen, esperada.origen);
+    EXPECT_EQ(ultimas[i].destino, esperada.destino);
+    EXPECT_EQ(ultimas[i].monto, esperada.monto);
+    EXPECT_EQ(ultimas[i]._timestamp, esperada._timestamp);
+    EXPECT_EQ(ultimas[i].secuencia, esperada.secuencia);
+  }
+}
+
+TEST_F(test_historial_frio, saldos_comprimidos_agrupan_dias_iguales) {
+  vector<monto> saldos = {100, 100, 100, 90, 90, 120, 100};
+
+  SaldosComprimidos comprimidos;
+  comprimidos.agregar(saldos, 4);
+  comprimidos.agregar({90, 120, 100}, 3);
+
+  EXPECT_EQ(comprimidos.cantidad(), saldos.size());
+  for (size_t i = 0; i < saldos.size(); i++) {
+    EXPECT_EQ(comprimidos.consultar(i), saldos[i]);
+  }
+}
+
+TEST_F(test_historial_frio, billetera_archivada_responde_igual_que_sin_archivar) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  for (int dia = 0; dia < 30; dia++) {
+    agregar_transaccion(blockchain, billetera1, billetera2, 1);
+    agregar_transaccion(blockchain, billetera2, billetera1, 2);
+    Calendario::avanzar_un_dia();
+  }
+
+  vector<Transaccion> antes = billetera1->ultimas_transacciones(100);
+  vector<monto> saldos_antes;
+  for (int dia = 0; dia < 35; dia++) {
+    saldos_antes.push_back(billetera1->saldo_al_fin_del_dia(Calendario::dia(dia)));
+  }
+
+  blockchain.archivar_historial(Calendario::dia(10));
+
+  EstadisticasMemoria estadisticas = billetera1->estadisticas_memoria();
+  EXPECT_EQ(estadisticas.transacciones_frias, 1 + 20 * 2);
+  EXPECT_EQ(estadisticas.transacciones_calientes, 10 * 2);
+  EXPECT_EQ(estadisticas.dias_frios, 20);
+  EXPECT_EQ(estadisticas.dias_calientes, 10);
+
+  vector<Transaccion> despues = billetera1->ultimas_transacciones(100);
+  ASSERT_EQ(despues.size(), antes.size());
+  for (size_t i = 0; i < antes.size(); i++) {
+    chequear_transaccion(despues[i], antes[i].origen, antes[i].destino, antes[i].monto);
+    EXPECT_EQ(despues[i]._timestamp, antes[i]._timestamp);
+    EXPECT_EQ(despues[i].secuencia, antes[i].secuencia);
+  }
+  for (int dia = 0; dia < 35; dia++) {
+    EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(dia)), saldos_antes[dia]);
+  }
+
+  // Las transacciones nuevas siguen impactando en el nivel caliente.
+  agregar_transaccion(blockchain, billetera1, billetera2, 5);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(30)), billetera1->saldo());
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(5)), saldos_antes[5]);
+}
+
+TEST_F(test_historial_frio, archivar_seguido_no_agranda_el_nivel_frio) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  // Dos transferencias por día y un archivado cada noche, como un proceso periódico.
+  for (int dia = 0; dia < 400; dia++) {
+    agregar_transaccion(blockchain, billetera1, billetera2, 1);
+    agregar_transaccion(blockchain, billetera2, billetera1, 1);
+    Calendario::avanzar_un_dia();
+    blockchain.archivar_historial(Calendario::dia(7));
+  }
+
+  EstadisticasMemoria estadisticas = billetera1->estadisticas_memoria();
+  EXPECT_EQ(estadisticas.transacciones_frias + estadisticas.transacciones_calientes, 1 + 400 * 2);
+  EXPECT_GT(estadisticas.transacciones_frias, 390 * 2);
+
+  size_t sin_comprimir = estadisticas.transacciones_frias * sizeof(Transaccion) + estadisticas.dias_frios * sizeof(monto);
+  EXPECT_LT(estadisticas.bytes_frios, sin_comprimir / 2);
+
+  vector<Transaccion> ultimas = billetera1->ultimas_transacciones(1000);
+  ASSERT_EQ(ultimas.size(), 1 + 400 * 2);
+  for (size_t i = 1; i < ultimas.size(); i++) {
+    EXPECT_GT(ultimas[i - 1].secuencia, ultimas[i].secuencia);
+  }
+}
+
+TEST_F(test_historial_frio, el_ranking_se_cuenta_aparte_y_no_se_archiva) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  vector<Billetera*> billeteras = blockchain.abrir_billeteras(10);
+  for (int i = 0; i < 500; i++) {
+    agregar_transaccion(blockchain, billeteras[0], billeteras[1 + i % 9], 0);
+    Calendario::avanzar_un_minuto();
+  }
+
+  EstadisticasMemoria antes = billeteras[0]->estadisticas_memoria();
+  // Al menos las salidas y los checkpoints del ranking histórico.
+  EXPECT_GE(antes.bytes_ranking, 500 * sizeof(pair<timestamp, id_billetera>) + 500 / 64 * sizeof(CheckpointRanking));
+
+  blockchain.archivar_historial(0);
+  EstadisticasMemoria despues = billeteras[0]->estadisticas_memoria();
+  EXPECT_EQ(despues.transacciones_calientes, 0);
+  EXPECT_EQ(despues.bytes_ranking, antes.bytes_ranking);
+
+  EstadisticasMemoria solo_saldo = BilleteraSoloSaldo(1, nullptr).estadisticas_memoria();
+  EXPECT_EQ(solo_saldo.bytes_ranking, 0);
+}
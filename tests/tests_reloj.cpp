@@ -0,0 +1,137 @@
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../reloj.h"
+#include "../blockchain.h"
+#include "../billetera.h"
+#include "../shards.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_reloj : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_reloj, dia_en_curso_coincide_con_dividir) {
+  DiaEnCurso dia;
+
+  vector<timestamp> ts = {0, 1, 86399, 86400, 86401, 3 * 86400 - 1, 3 * 86400, 86400, 0, 10 * 86400 + 5};
+  for (timestamp t : ts) {
+    EXPECT_EQ(dia.indice(t), static_cast<int>(t / 86400)) << t;
+  }
+}
+
+TEST_F(test_reloj, reloj_manual) {
+  RelojManual reloj(100);
+  EXPECT_EQ(reloj.ahora(), 100);
+
+  reloj.avanzar_un_minuto();
+  EXPECT_EQ(reloj.ahora(), 160);
+  reloj.avanzar_un_dia();
+  EXPECT_EQ(reloj.ahora(), 160 + 86400);
+  reloj.fijar(5);
+  EXPECT_EQ(reloj.ahora(), 5);
+}
+
+TEST_F(test_reloj, reloj_grueso_sigue_al_del_sistema) {
+  RelojSistema sistema;
+  RelojGrueso grueso(10);
+
+  timestamp antes = sistema.ahora();
+  timestamp t = grueso.ahora();
+  EXPECT_GE(t + 1, antes);
+  EXPECT_LE(t, sistema.ahora());
+}
+
+TEST_F(test_reloj, la_blockchain_usa_su_reloj_y_no_el_calendario) {
+  Calendario::fijar(Calendario::dia(50));
+  RelojManual reloj(Calendario::dia(2));
+  Blockchain blockchain(&reloj);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  reloj.avanzar_un_dia();
+  agregar_transaccion(blockchain, billetera1, billetera2, 30);
+
+  EXPECT_EQ(blockchain.transacciones().front()._timestamp, Calendario::dia(2));
+  EXPECT_EQ(blockchain.transacciones().back()._timestamp, Calendario::dia(3));
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(2)), 100);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(3)), 70);
+}
+
+TEST_F(test_reloj, blockchains_con_relojes_propios_en_hilos_distintos) {
+  const int cantidad = 4;
+  const int dias = 20;
+  vector<double> saldos(cantidad * dias);
+
+  vector<thread> hilos;
+  for (int h = 0; h < cantidad; h++) {
+    hilos.emplace_back([h, &saldos] {
+      // Cada hilo arranca en un día distinto y avanza a su ritmo.
+      RelojManual reloj(Calendario::dia(h * 100));
+      Blockchain blockchain(&reloj);
+      vector<Billetera*> billeteras = blockchain.abrir_billeteras(2);
+
+      for (int d = 0; d < dias; d++) {
+        for (int m = 0; m < 4; m++) {
+          reloj.avanzar_un_minuto();
+          blockchain.agregar_transaccion(billeteras[0], billeteras[1]->id(), 1);
+        }
+        saldos[h * dias + d] = billeteras[0]->saldo_al_fin_del_dia(reloj.ahora());
+        reloj.avanzar_un_dia();
+      }
+    });
+  }
+  for (thread& hilo : hilos) {
+    hilo.join();
+  }
+
+  for (int h = 0; h < cantidad; h++) {
+    for (int d = 0; d < dias; d++) {
+      EXPECT_EQ(saldos[h * dias + d], 100 - 4 * (d + 1));
+    }
+  }
+}
+
+TEST_F(test_reloj, los_shards_usan_el_reloj_del_coordinador) {
+  RelojManual reloj(Calendario::dia(7));
+  CoordinadorShards<PoliticaCompleta> coordinador(2, &reloj);
+
+  id_billetera a = coordinador.abrir_billetera(); // shard 0
+  id_billetera b = coordinador.abrir_billetera(); // shard 1
+  reloj.avanzar_un_minuto();
+  EXPECT_TRUE(coordinador.transferir(a, b, 10));
+
+  vector<Transaccion> transacciones = coordinador.transacciones();
+  ASSERT_EQ(transacciones.size(), 3);
+  EXPECT_EQ(transacciones.front()._timestamp, Calendario::dia(7));
+  EXPECT_EQ(transacciones.back()._timestamp, Calendario::dia(7) + 60);
+}
+
+TEST_F(test_reloj, saldo_al_fin_del_dia_por_indice_coincide_con_el_de_timestamp) {
+  RelojManual reloj(Calendario::dia(3));
+  Blockchain blockchain(&reloj);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  for (int d = 0; d < 5; d++) {
+    agregar_transaccion(blockchain, billetera1, billetera2, d + 1);
+    reloj.avanzar_un_dia();
+  }
+
+  // Consultas alternando días, para que el día en curso se recalcule.
+  for (int d = 0; d < 10; d++) {
+    for (timestamp t : {Calendario::dia(d), Calendario::dia(d) + 86399, Calendario::dia(9 - d) + 5}) {
+      EXPECT_EQ(billetera1->saldo_al_fin_del_dia(t), billetera1->saldo_al_fin_del_dia_indice(t / 86400)) << t;
+    }
+  }
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia_indice(2), 0);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia_indice(3), 99);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia_indice(7), 85);
+}
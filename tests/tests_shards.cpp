@@ -0,0 +1,164 @@
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../shards.h"
+#include "../billetera.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_shards : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_shards, reparte_las_billeteras_entre_los_shards) {
+  CoordinadorShards<PoliticaCompleta> coordinador(3);
+
+  vector<id_billetera> ids;
+  for (int i = 0; i < 6; i++) {
+    ids.push_back(coordinador.abrir_billetera());
+  }
+
+  for (int i = 0; i < 6; i++) {
+    EXPECT_EQ(coordinador.shard_de(ids[i]), i % 3);
+    EXPECT_EQ(coordinador.saldo(ids[i]), 100);
+  }
+  EXPECT_EQ(coordinador.cantidad_billeteras(), 6);
+  EXPECT_EQ(coordinador.transacciones().size(), 6);
+}
+
+TEST_F(test_shards, transfiere_dentro_de_un_shard_y_entre_shards) {
+  Calendario::fijar(0);
+  CoordinadorShards<PoliticaCompleta> coordinador(2);
+
+  id_billetera a = coordinador.abrir_billetera(); // shard 0
+  id_billetera b = coordinador.abrir_billetera(); // shard 1
+  id_billetera c = coordinador.abrir_billetera(); // shard 0
+
+  Calendario::avanzar_un_minuto();
+  EXPECT_TRUE(coordinador.transferir(a, c, 10));
+  Calendario::avanzar_un_minuto();
+  EXPECT_TRUE(coordinador.transferir(a, b, 30));
+
+  EXPECT_EQ(coordinador.saldo(a), 60);
+  EXPECT_EQ(coordinador.saldo(b), 130);
+  EXPECT_EQ(coordinador.saldo(c), 110);
+
+  // La transferencia entre shards aparece una sola vez.
+  vector<Transaccion> transacciones = coordinador.transacciones();
+  EXPECT_EQ(transacciones.size(), 5);
+  chequear_transaccion(transacciones[3], a, c, 10);
+  chequear_transaccion(transacciones[4], a, b, 30);
+}
+
+TEST_F(test_shards, rechaza_transferencias_entre_shards_invalidas_sin_dejar_reservas) {
+  CoordinadorShards<PoliticaCompleta> coordinador(2);
+
+  id_billetera a = coordinador.abrir_billetera(); // shard 0
+  id_billetera b = coordinador.abrir_billetera(); // shard 1
+
+  EXPECT_FALSE(coordinador.transferir(a, b, 101));
+  EXPECT_FALSE(coordinador.transferir(a, b + 2, 10)); // destino no registrado en el shard 1
+  EXPECT_FALSE(coordinador.transferir(a, a, 10));
+
+  // Si hubiera quedado algo reservado, no alcanzaría el saldo.
+  EXPECT_TRUE(coordinador.transferir(a, b, 100));
+  EXPECT_EQ(coordinador.saldo(a), 0);
+  EXPECT_EQ(coordinador.saldo(b), 200);
+}
+
+TEST_F(test_shards, conserva_el_dinero_con_transferencias_concurrentes) {
+  CoordinadorShards<PoliticaSoloSaldo> coordinador(4);
+
+  vector<id_billetera> ids;
+  for (int i = 0; i < 8; i++) {
+    ids.push_back(coordinador.abrir_billetera());
+  }
+
+  vector<thread> clientes;
+  for (int c = 0; c < 4; c++) {
+    clientes.emplace_back([&coordinador, &ids, c] {
+      for (int i = 0; i < 200; i++) {
+        coordinador.transferir(ids[(c + i) % 8], ids[(c + 3 * i + 1) % 8], 1 + i % 7);
+      }
+    });
+  }
+  for (thread& cliente : clientes) {
+    cliente.join();
+  }
+
+  monto total = 0;
+  for (id_billetera id : ids) {
+    total += coordinador.saldo(id);
+  }
+  EXPECT_EQ(total, 800);
+}
+
+TEST_F(test_shards, la_confirmacion_no_retrocede_si_cambia_el_dia_entre_fases) {
+  // Dos blockchains como las de dos shards, usando las fases a mano para
+  // intercalar una transferencia local entre la preparación y la confirmación.
+  Blockchain shard_origen(1, 2);
+  Blockchain shard_destino(2, 2);
+  Calendario::fijar(0);
+
+  Billetera* origen = shard_origen.abrir_billetera();
+  Billetera* destino = shard_destino.abrir_billetera();
+  Billetera* vecina = shard_destino.abrir_billetera();
+
+  ASSERT_TRUE(shard_origen.reservar_debito(origen, 15));
+  ASSERT_TRUE(shard_destino.preparar_credito(destino->id()));
+  timestamp t = Calendario::dia(1) - 1; // 23:59:59
+
+  // Pasa la medianoche y el shard del destino registra una transferencia local.
+  Calendario::fijar(Calendario::dia(1) + 59);
+  ASSERT_TRUE(shard_destino.agregar_transaccion(vecina, destino->id(), 10));
+
+  timestamp registrado = shard_destino.confirmar_credito(origen->id(), destino->id(), 15, t);
+  EXPECT_EQ(registrado, Calendario::dia(1) + 59);
+  EXPECT_EQ(shard_origen.confirmar_debito(origen->id(), destino->id(), 15, registrado), registrado);
+
+  // Los registros siguen en orden cronológico.
+  timestamp anterior = 0;
+  for (const Transaccion& tx : shard_destino.transacciones()) {
+    EXPECT_GE(tx._timestamp, anterior);
+    anterior = tx._timestamp;
+  }
+
+  EXPECT_EQ(destino->saldo(), 125);
+  EXPECT_EQ(destino->saldo_al_fin_del_dia(Calendario::dia(0)), 100);
+  EXPECT_EQ(destino->saldo_al_fin_del_dia(Calendario::dia(1)), 125);
+  EXPECT_EQ(origen->saldo_al_fin_del_dia(Calendario::dia(1)), 85);
+
+  vector<Transaccion> ultimas = destino->ultimas_transacciones_al(Calendario::dia(1) + 59, 10);
+  ASSERT_EQ(ultimas.size(), 3);
+  EXPECT_EQ(ultimas[0].origen, origen->id());
+  EXPECT_EQ(ultimas[0].monto, 15);
+}
+
+TEST_F(test_shards, reservas_con_montos_fraccionarios_no_dejan_residuo) {
+  Blockchain shard_origen(1, 2);
+  Blockchain shard_destino(2, 2);
+
+  Billetera* origen = shard_origen.abrir_billetera();
+  Billetera* vecina = shard_origen.abrir_billetera();
+  Billetera* destino = shard_destino.abrir_billetera();
+
+  // 0.1 + 0.2 - 0.1 - 0.2 no da exactamente 0 en double.
+  ASSERT_TRUE(shard_origen.reservar_debito(origen, 0.1));
+  ASSERT_TRUE(shard_origen.reservar_debito(origen, 0.2));
+  ASSERT_TRUE(shard_destino.preparar_credito(destino->id()));
+  ASSERT_TRUE(shard_destino.preparar_credito(destino->id()));
+  timestamp t = shard_destino.confirmar_credito(origen->id(), destino->id(), 0.1, 0);
+  shard_origen.confirmar_debito(origen->id(), destino->id(), 0.1, t);
+  t = shard_destino.confirmar_credito(origen->id(), destino->id(), 0.2, 0);
+  shard_origen.confirmar_debito(origen->id(), destino->id(), 0.2, t);
+
+  // Sin reservas pendientes, la billetera puede gastar todo y cerrarse.
+  EXPECT_TRUE(shard_origen.agregar_transaccion(origen, vecina->id(), origen->saldo()));
+  EXPECT_TRUE(shard_origen.cerrar_billetera(origen, vecina->id()));
+}